@@ -0,0 +1,119 @@
+// bench_optimizer [script.slp]
+// measures what the display list optimizer saves: how much smaller the
+// list gets, how long the pass takes and how long rendering and SVG export
+// take with and without it. without a script a drawing of grid lines made
+// of short collinear pieces, some drawn twice, is used
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "interpreter.hpp"
+#include "interpreter_semantic_error.hpp"
+#include "display_list.hpp"
+#include "display_list_optimizer.hpp"
+#include "rasterizer.hpp"
+#include "svg_writer.hpp"
+
+static const char * SVG_FILE = "bench_optimizer.svg";
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// a grid of lines each drawn as steps pieces, every other row twice, and
+// a circle on the diagonal per row
+static std::string gridProgram(int lines, int steps)
+{
+    std::ostringstream program;
+    program << "(begin";
+    for (int i = 0; i < lines; i++)
+    {
+        for (int repeat = 0; repeat < (i % 2 == 0 ? 2 : 1); repeat++)
+        {
+            for (int j = 0; j < steps; j++)
+            {
+                program << " (draw (line (point " << j << " " << i * 4 << ") (point " << j + 1 << " " << i * 4 << ")))";
+            }
+        }
+        for (int j = 0; j < steps; j++)
+        {
+            program << " (draw (line (point " << i * 4 << " " << j << ") (point " << i * 4 << " " << j + 1 << ")))";
+        }
+        program << " (draw (arc (point " << i * 4 << " " << i * 4 << ") (point " << i * 4 + 1 << " " << i * 4 << ") (* 2 pi)))";
+    }
+    program << ")";
+    return program.str();
+}
+
+// render and export graphics, reporting how long each took
+static void time(const char * name, const DisplayList & graphics, const OptimizedDisplayList * optimized)
+{
+    auto begin = std::chrono::steady_clock::now();
+    Rasterizer raster(1024, 1024);
+    raster.fit(displayListBounds(graphics), 8);
+    raster.draw(graphics);
+    double render = secondsSince(begin);
+
+    begin = std::chrono::steady_clock::now();
+    bool written = optimized ? writeSvg(SVG_FILE, *optimized) : writeSvg(SVG_FILE, graphics);
+    double svg = secondsSince(begin);
+    std::ifstream file(SVG_FILE, std::ios::binary | std::ios::ate);
+    long long bytes = written ? (long long)file.tellg() : -1;
+    std::remove(SVG_FILE);
+
+    std::cout << name << ": " << graphics.size() << " primitives, render " << render * 1e3
+              << " ms, svg " << svg * 1e3 << " ms, " << bytes << " bytes" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 2)
+    {
+        std::cerr << "Error: usage is bench_optimizer [script.slp]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Interpreter interp;
+    bool parsed;
+    if (argc == 2)
+    {
+        std::ifstream script(argv[1]);
+        parsed = script && interp.parse(script);
+    }
+    else
+    {
+        std::istringstream script(gridProgram(200, 200));
+        parsed = interp.parse(script);
+    }
+    if (!parsed)
+    {
+        std::cerr << "Error: could not parse the program" << std::endl;
+        return EXIT_FAILURE;
+    }
+    try
+    {
+        interp.eval();
+    }
+    catch (const InterpreterSemanticError & ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    interp.setGraphics();
+    DisplayList graphics = interp.getGraphics();
+
+    OptimizedDisplayList optimized = optimizeDisplayList(graphics);
+    const OptimizerStats & stats = optimized.stats;
+    std::cout << "optimizer: " << stats.input << " to " << stats.output << " primitives ("
+              << stats.ratio() * 100 << "%), " << stats.duplicates << " duplicates, " << stats.merged
+              << " merged, " << stats.polylines << " polylines, in " << stats.seconds * 1e3 << " ms" << std::endl;
+
+    time("as drawn", graphics, nullptr);
+    time("optimized", optimized.graphics, &optimized);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+// bench_pipeline [count]
+// measures the sustained rate primitives get from a running program to the
+// scene: QtInterpreter evaluates on its own thread and queues an item per
+// primitive, the canvas takes them on its frame timer as sldraw does. the
+// bare queue is timed as well to show what the handoff itself costs
+#include <string>
+#include <thread>
+#include <iostream>
+#include <cstdlib>
+
+#include <QApplication>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+
+#include "spsc_queue.hpp"
+#include "qt_interpreter.hpp"
+#include "canvas_widget.hpp"
+
+static void report(const char * name, size_t count, qint64 nsecs)
+{
+    double seconds = nsecs / 1e9;
+    std::cout << name << ": " << count << " primitives in " << seconds * 1e3 << " ms, "
+              << size_t(count / seconds) << " primitives/s" << std::endl;
+}
+
+// one thread pushes count values through the queue to this one
+static void benchQueue(size_t count)
+{
+    SpscQueue<QGraphicsItem *> queue(8192);
+    QElapsedTimer timer;
+    timer.start();
+    std::thread producer([&queue, count]
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            while (!queue.tryPush(reinterpret_cast<QGraphicsItem *>(i + 1)))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    size_t received = 0;
+    QGraphicsItem * item;
+    while (received < count)
+    {
+        if (queue.tryPop(item))
+        {
+            received++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    report("queue", count, timer.nsecsElapsed());
+}
+
+// a program drawing count points, lines and arcs, from parsing to the
+// last item in the scene
+static bool benchPipeline(size_t count)
+{
+    QString program = "(begin";
+    for (size_t i = 0; i < count; i++)
+    {
+        double x = i % 1000, y = i / 1000;
+        switch (i % 3)
+        {
+        case 0:
+            program += QString(" (draw (point %1 %2))").arg(x).arg(y);
+            break;
+        case 1:
+            program += QString(" (draw (line (point %1 %2) (point %3 %2)))").arg(x).arg(y).arg(x + 0.5);
+            break;
+        default:
+            program += QString(" (draw (arc (point %1 %2) (point %3 %2) pi))").arg(x).arg(y).arg(x + 0.5);
+        }
+    }
+    program += ")";
+
+    QThread thread;
+    QtInterpreter interp;
+    CanvasWidget canvas;
+    QGraphicsScene * scene = canvas.findChild<QGraphicsScene *>();
+    interp.moveToThread(&thread);
+    canvas.drainFrom(interp.itemQueue());
+    bool done = false;
+    QObject::connect(&interp, &QtInterpreter::running, &canvas, [&done](bool busy) { done = !busy; });
+    thread.start();
+
+    QElapsedTimer timer;
+    timer.start();
+    QMetaObject::invokeMethod(&interp, "parseAndEvaluate", Qt::QueuedConnection, Q_ARG(QString, program));
+    //the running signal comes after the last item was queued
+    while (!done || !interp.itemQueue()->empty())
+    {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 1);
+    }
+    qint64 nsecs = timer.nsecsElapsed();
+    thread.quit();
+    thread.wait();
+
+    if (scene->items().size() != int(count))
+    {
+        std::cerr << "Error: " << scene->items().size() << " of " << count << " primitives reached the scene" << std::endl;
+        return false;
+    }
+    report("interpreter to scene", count, nsecs);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = 100000;
+    if (argc == 2)
+    {
+        count = std::strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2 || count == 0)
+    {
+        std::cerr << "Error: usage is bench_pipeline [count]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //nothing is shown
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    benchQueue(count);
+    return benchPipeline(count) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
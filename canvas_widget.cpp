@@ -1,22 +1,76 @@
 #include "canvas_widget.hpp"
+#include "tiled_graphics_view.hpp"
 
 #include <QWidget>
 #include <QGraphicsItem>
 #include <QGraphicsScene>
 #include <QGraphicsView>
 #include <QLayout>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <iostream>
 
 CanvasWidget::CanvasWidget(QWidget * parent): QWidget(parent)
 {
     scene = new QGraphicsScene(this);
-    QGraphicsView *graphicsLayout = new QGraphicsView(scene, this);
+    QGraphicsView *graphicsLayout = new TiledGraphicsView(scene, this);
     QBoxLayout *canvasLayout = new QVBoxLayout;
     canvasLayout->addWidget(graphicsLayout);
     this->setLayout(canvasLayout);
+
+    queue = nullptr;
+    frameTimer = new QTimer(this);
+    frameTimer->setInterval(FRAME_MS);
+    connect(frameTimer, &QTimer::timeout, this, &CanvasWidget::drainFrame);
+}
+
+void CanvasWidget::drainFrom(SpscQueue<QGraphicsItem *> * queue)
+{
+    this->queue = queue;
+    frameTimer->start();
 }
 
 void CanvasWidget::addGraphic(QGraphicsItem * item)
 {
     scene->addItem(item);
 }
+
+void CanvasWidget::removeGraphics(QVector<QGraphicsItem *> items)
+{
+    //the items may still be queued, everything queued before the removal
+    //was asked for is added first
+    drain(-1);
+    for (int i = 0; i < items.size(); i++)
+    {
+        scene->removeItem(items[i]);
+        delete items[i];
+    }
+}
+
+void CanvasWidget::drainFrame()
+{
+    drain(DRAIN_BUDGET_MS);
+}
+
+//adds queued items until the queue is empty or budget milliseconds have
+//passed, a negative budget empties the queue
+void CanvasWidget::drain(qint64 budget)
+{
+    if (!queue)
+    {
+        return;
+    }
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QGraphicsItem * item;
+    int taken = 0;
+    while (queue->tryPop(item))
+    {
+        scene->addItem(item);
+        //reading the clock costs more than adding an item
+        if (budget >= 0 && ++taken % 256 == 0 && elapsed.elapsed() >= budget)
+        {
+            return;
+        }
+    }
+}
@@ -2,9 +2,13 @@
 #define CANVAS_WIDGET_HPP
 
 #include <QWidget>
+#include <QVector>
+
+#include "spsc_queue.hpp"
 
 class QGraphicsItem;
 class QGraphicsScene;
+class QTimer;
 
 class CanvasWidget: public QWidget{
   Q_OBJECT
@@ -13,13 +17,30 @@ public:
 
   CanvasWidget(QWidget * parent = nullptr);
 
+  // take the items of a running evaluation from queue once every frame
+  void drainFrom(SpscQueue<QGraphicsItem *> * queue);
+
 public slots:
 
   void addGraphic(QGraphicsItem * item);
+  void removeGraphics(QVector<QGraphicsItem *> items);
+
+private slots:
+
+  void drainFrame();
 
 private:
 
+  //a frame adds queued items for at most DRAIN_BUDGET_MS so the window
+  //keeps repainting however fast the interpreter draws
+  static const int FRAME_MS = 16;
+  static const int DRAIN_BUDGET_MS = 8;
+
   QGraphicsScene * scene;
+  SpscQueue<QGraphicsItem *> * queue;
+  QTimer * frameTimer;
+
+  void drain(qint64 budget);
 };
 
 #endif
@@ -0,0 +1,295 @@
+// system includes
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+
+// module includes
+#include "display_list.hpp"
+#include "scene_graph.hpp"
+
+//an empty box is inverted so that including anything makes it valid
+Bounds::Bounds()
+{
+    left = std::numeric_limits<Number>::infinity();
+    top = std::numeric_limits<Number>::infinity();
+    right = -std::numeric_limits<Number>::infinity();
+    bottom = -std::numeric_limits<Number>::infinity();
+}
+
+bool Bounds::empty() const
+{
+    return left > right || top > bottom;
+}
+
+Number Bounds::width() const
+{
+    return empty() ? 0 : right - left;
+}
+
+Number Bounds::height() const
+{
+    return empty() ? 0 : bottom - top;
+}
+
+void Bounds::include(Number x, Number y)
+{
+    left = std::min(left, x);
+    top = std::min(top, y);
+    right = std::max(right, x);
+    bottom = std::max(bottom, y);
+}
+
+void Bounds::include(const Bounds & other)
+{
+    if (!other.empty())
+    {
+        include(other.left, other.top);
+        include(other.right, other.bottom);
+    }
+}
+
+bool Bounds::intersects(const Bounds & other) const
+{
+    return !empty() && !other.empty() && left <= other.right && other.left <= right
+        && top <= other.bottom && other.top <= bottom;
+}
+
+bool Bounds::contains(Number x, Number y) const
+{
+    return x >= left && x <= right && y >= top && y <= bottom;
+}
+
+Bounds arcBounds(Point center, Number radius, Number start, Number span)
+{
+    const Number twoPi = 2 * atan2(0, -1);
+    Bounds bounds;
+    if (std::fabs(span) >= twoPi)
+    {
+        bounds.include(center.x - radius, center.y - radius);
+        bounds.include(center.x + radius, center.y + radius);
+        return bounds;
+    }
+
+    //the two ends of the arc
+    Number end = start + span;
+    bounds.include(center.x + radius * cos(start), center.y - radius * sin(start));
+    bounds.include(center.x + radius * cos(end), center.y - radius * sin(end));
+
+    //and every right, top, left or bottom extreme that the arc sweeps over
+    Number low = std::min(start, end);
+    Number high = std::max(start, end);
+    for (int quadrant = 0; quadrant < 4; quadrant++)
+    {
+        Number angle = quadrant * twoPi / 4;
+        angle += twoPi * std::ceil((low - angle) / twoPi);
+        if (angle <= high)
+        {
+            bounds.include(center.x + radius * cos(angle), center.y - radius * sin(angle));
+        }
+    }
+    return bounds;
+}
+
+Bounds atomBounds(const Atom & atom)
+{
+    Bounds bounds;
+    if (atom.type == PointType)
+    {
+        bounds.include(atom.value.point_value.x, atom.value.point_value.y);
+        bounds.include(atom.value.point_value.x + 2, atom.value.point_value.y + 2);
+    }
+    else if (atom.type == LineType)
+    {
+        bounds.include(atom.value.line_value.first.x, atom.value.line_value.first.y);
+        bounds.include(atom.value.line_value.second.x, atom.value.line_value.second.y);
+    }
+    else if (atom.type == ArcType)
+    {
+        const Arc & arc = atom.value.arc_value;
+        Number dx = arc.start.x - arc.center.x;
+        Number dy = arc.start.y - arc.center.y;
+        bounds = arcBounds(arc.center, std::sqrt(dx * dx + dy * dy), atan2(-dy, dx), arc.span);
+    }
+    else if (atom.type == PolylineType || atom.type == PolygonType)
+    {
+        const PointList & vertices = atom.points();
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            bounds.include(vertices[i].x, vertices[i].y);
+        }
+    }
+    else if (atom.type == GroupType)
+    {
+        //the box kept with the group, moved along with it
+        const Instance & instance = atom.instance();
+        bounds = transformBounds(instance.transform, groupBounds(*instance.group));
+    }
+    return bounds;
+}
+
+Bounds displayListBounds(const DisplayList & graphics)
+{
+    Bounds bounds;
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        bounds.include(atomBounds(graphics[i]));
+    }
+    return bounds;
+}
+
+//mixes the bits of one number into a 64 bit FNV-1a hash, adding zero
+//turns -0 into 0 so numbers that compare equal hash equal
+static void hashNumber(uint64_t & hash, Number value)
+{
+    value += 0.0;
+    unsigned char bytes[sizeof(Number)];
+    std::memcpy(bytes, &value, sizeof(Number));
+    for (size_t i = 0; i < sizeof(Number); i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+}
+
+size_t hashAtom(const Atom & atom)
+{
+    uint64_t hash = 14695981039346656037ull;
+    hash = (hash ^ atom.type) * 1099511628211ull;
+    if (atom.type == PointType)
+    {
+        hashNumber(hash, atom.value.point_value.x);
+        hashNumber(hash, atom.value.point_value.y);
+    }
+    else if (atom.type == LineType)
+    {
+        hashNumber(hash, atom.value.line_value.first.x);
+        hashNumber(hash, atom.value.line_value.first.y);
+        hashNumber(hash, atom.value.line_value.second.x);
+        hashNumber(hash, atom.value.line_value.second.y);
+    }
+    else if (atom.type == ArcType)
+    {
+        hashNumber(hash, atom.value.arc_value.center.x);
+        hashNumber(hash, atom.value.arc_value.center.y);
+        hashNumber(hash, atom.value.arc_value.start.x);
+        hashNumber(hash, atom.value.arc_value.start.y);
+        hashNumber(hash, atom.value.arc_value.span);
+    }
+    else if (atom.type == PolylineType || atom.type == PolygonType)
+    {
+        const PointList & vertices = atom.points();
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            hashNumber(hash, vertices[i].x);
+            hashNumber(hash, vertices[i].y);
+        }
+    }
+    else if (atom.type == GroupType)
+    {
+        //the shape by identity, not by its atoms
+        const Transform & t = atom.instance().transform;
+        uint64_t shape = uint64_t(reinterpret_cast<uintptr_t>(atom.instance().group.get()));
+        hash = (hash ^ shape) * 1099511628211ull;
+        hashNumber(hash, t.a);
+        hashNumber(hash, t.b);
+        hashNumber(hash, t.c);
+        hashNumber(hash, t.d);
+        hashNumber(hash, t.e);
+        hashNumber(hash, t.f);
+    }
+    return size_t(hash);
+}
+
+bool sameGeometry(const Atom & a, const Atom & b)
+{
+    if (a.type != b.type)
+    {
+        return false;
+    }
+    if (a.type == PointType)
+    {
+        return a.value.point_value.x == b.value.point_value.x
+            && a.value.point_value.y == b.value.point_value.y;
+    }
+    if (a.type == LineType)
+    {
+        return a.value.line_value.first.x == b.value.line_value.first.x
+            && a.value.line_value.first.y == b.value.line_value.first.y
+            && a.value.line_value.second.x == b.value.line_value.second.x
+            && a.value.line_value.second.y == b.value.line_value.second.y;
+    }
+    if (a.type == ArcType)
+    {
+        return a.value.arc_value.center.x == b.value.arc_value.center.x
+            && a.value.arc_value.center.y == b.value.arc_value.center.y
+            && a.value.arc_value.start.x == b.value.arc_value.start.x
+            && a.value.arc_value.start.y == b.value.arc_value.start.y
+            && a.value.arc_value.span == b.value.arc_value.span;
+    }
+    if (a.type == GroupType)
+    {
+        const Instance & first = a.instance();
+        const Instance & second = b.instance();
+        const Transform & t = first.transform;
+        const Transform & u = second.transform;
+        return first.group == second.group && t.a == u.a && t.b == u.b
+            && t.c == u.c && t.d == u.d && t.e == u.e && t.f == u.f;
+    }
+    if (a.type == PolylineType || a.type == PolygonType)
+    {
+        const PointList & first = a.points();
+        const PointList & second = b.points();
+        if (first.size() != second.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < first.size(); i++)
+        {
+            if (first[i].x != second[i].x || first[i].y != second[i].y)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+DisplayListDiff diffDisplayLists(const DisplayList & before, const DisplayList & after)
+{
+    //old atoms by hash, an entry is erased once it has been matched
+    std::unordered_multimap<size_t, size_t> old;
+    old.reserve(before.size());
+    for (size_t i = 0; i < before.size(); i++)
+    {
+        old.insert(std::make_pair(hashAtom(before[i]), i));
+    }
+
+    DisplayListDiff diff;
+    diff.kept.resize(after.size(), DIFF_ADDED);
+    std::vector<bool> matched(before.size(), false);
+    for (size_t i = 0; i < after.size(); i++)
+    {
+        auto range = old.equal_range(hashAtom(after[i]));
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (sameGeometry(before[it->second], after[i]))
+            {
+                matched[it->second] = true;
+                diff.kept[i] = it->second;
+                old.erase(it);
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < before.size(); i++)
+    {
+        if (!matched[i])
+        {
+            diff.removed.push_back(i);
+        }
+    }
+    return diff;
+}
@@ -0,0 +1,74 @@
+#ifndef DISPLAY_LIST_HPP
+#define DISPLAY_LIST_HPP
+
+// system includes
+#include <vector>
+#include <cstddef>
+
+// module includes
+#include "expression.hpp"
+
+// A DisplayList is the sequence of point, line, arc, polyline, polygon and
+// group atoms a program draws, in drawing order (see
+// Environment::getGraphics)
+typedef std::vector<Atom> DisplayList;
+
+// An axis aligned box in scene coordinates, y grows downward like the canvas
+struct Bounds
+{
+  Number left;
+  Number top;
+  Number right;
+  Number bottom;
+
+  // a box that contains nothing
+  Bounds();
+
+  bool empty() const;
+  Number width() const;
+  Number height() const;
+
+  // grow the box to contain a point or another box
+  void include(Number x, Number y);
+  void include(const Bounds & other);
+
+  bool intersects(const Bounds & other) const;
+  bool contains(Number x, Number y) const;
+};
+
+// the exact box swept by an arc of the given radius around center,
+// starting at angle start (radians, counter clockwise on screen) and
+// spanning span radians (negative is clockwise)
+Bounds arcBounds(Point center, Number radius, Number start, Number span);
+
+// the box an atom covers when drawn, ignoring the pen width
+// points are drawn as 2x2 circles with their top left at the point
+Bounds atomBounds(const Atom & atom);
+
+// the box of everything in a display list
+Bounds displayListBounds(const DisplayList & graphics);
+
+// a hash of the type and geometry of an atom, equal atoms hash equal
+size_t hashAtom(const Atom & atom);
+
+// whether two atoms draw exactly the same thing, groups only if they are
+// the same instance of the same shape
+bool sameGeometry(const Atom & a, const Atom & b);
+
+// marks an atom of the new list that has no equal in the old list
+const size_t DIFF_ADDED = size_t(-1);
+
+// How to turn one display list into another. Atoms are matched by
+// hashAtom, each old atom at most once, so duplicates are counted.
+struct DisplayListDiff
+{
+  // for every atom of the new list, the index of the equal old atom it
+  // keeps, or DIFF_ADDED
+  std::vector<size_t> kept;
+  // the indices of the old atoms nothing was matched to
+  std::vector<size_t> removed;
+};
+
+DisplayListDiff diffDisplayLists(const DisplayList & before, const DisplayList & after);
+
+#endif
@@ -0,0 +1,191 @@
+// system includes
+#include <cmath>
+#include <chrono>
+#include <unordered_map>
+
+// module includes
+#include "display_list_optimizer.hpp"
+
+// the largest sine of the angle between two lines that still counts as
+// collinear, far below what a pixel can show
+static const Number COLLINEAR_TOLERANCE = 1e-9;
+
+OptimizerStats::OptimizerStats(): input(0), output(0), duplicates(0), merged(0), polylines(0), seconds(0)
+{
+}
+
+double OptimizerStats::ratio() const
+{
+    return input == 0 ? 1 : double(output) / input;
+}
+
+static bool samePoint(const Point & a, const Point & b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+static size_t hashPoint(const Point & point)
+{
+    Atom atom;
+    atom.type = PointType;
+    atom.value.point_value = point;
+    return hashAtom(atom);
+}
+
+//whether next carries on from line in the same direction
+static bool continues(const Line & line, const Line & next)
+{
+    if (!samePoint(line.second, next.first))
+    {
+        return false;
+    }
+    Number dx1 = line.second.x - line.first.x, dy1 = line.second.y - line.first.y;
+    Number dx2 = next.second.x - next.first.x, dy2 = next.second.y - next.first.y;
+    Number length = std::sqrt(dx1 * dx1 + dy1 * dy1) * std::sqrt(dx2 * dx2 + dy2 * dy2);
+    if (length == 0)
+    {
+        return false;
+    }
+    Number cross = dx1 * dy2 - dy1 * dx2;
+    Number dot = dx1 * dx2 + dy1 * dy2;
+    return dot > 0 && std::fabs(cross) <= COLLINEAR_TOLERANCE * length;
+}
+
+OptimizedDisplayList optimizeDisplayList(const DisplayList & graphics)
+{
+    auto begin = std::chrono::steady_clock::now();
+    OptimizedDisplayList optimized;
+    OptimizerStats & stats = optimized.stats;
+    stats.input = graphics.size();
+
+    //the first of every group of equal atoms, in drawing order
+    std::unordered_multimap<size_t, size_t> seen;
+    seen.reserve(graphics.size());
+    DisplayList unique;
+    unique.reserve(graphics.size());
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        size_t hash = hashAtom(graphics[i]);
+        bool duplicate = false;
+        auto range = seen.equal_range(hash);
+        for (auto it = range.first; it != range.second && !duplicate; ++it)
+        {
+            duplicate = sameGeometry(unique[it->second], graphics[i]);
+        }
+        if (duplicate)
+        {
+            stats.duplicates++;
+            continue;
+        }
+        seen.insert(std::make_pair(hash, unique.size()));
+        unique.push_back(graphics[i]);
+    }
+
+    //a chain of collinear lines becomes its first line stretched to the
+    //end of the last
+    optimized.graphics.reserve(unique.size());
+    for (size_t i = 0; i < unique.size(); i++)
+    {
+        if (unique[i].type == LineType && !optimized.graphics.empty()
+            && optimized.graphics.back().type == LineType
+            && continues(optimized.graphics.back().value.line_value, unique[i].value.line_value))
+        {
+            optimized.graphics.back().value.line_value.second = unique[i].value.line_value.second;
+            stats.merged++;
+            continue;
+        }
+        optimized.graphics.push_back(unique[i]);
+    }
+    stats.output = optimized.graphics.size();
+
+    optimized.polylines = joinPolylines(optimized.graphics);
+    for (size_t i = 0; i < optimized.polylines.size(); i++)
+    {
+        if (optimized.polylines[i].size() > 2)
+        {
+            stats.polylines++;
+        }
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return optimized;
+}
+
+std::vector<Polyline> joinPolylines(const DisplayList & graphics)
+{
+    //every line is listed under both of its ends
+    std::vector<const Line *> lines;
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        if (graphics[i].type == LineType)
+        {
+            lines.push_back(&graphics[i].value.line_value);
+        }
+    }
+    std::unordered_multimap<size_t, size_t> ends;
+    ends.reserve(2 * lines.size());
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        ends.insert(std::make_pair(hashPoint(lines[i]->first), i));
+        ends.insert(std::make_pair(hashPoint(lines[i]->second), i));
+    }
+    std::vector<bool> used(lines.size(), false);
+
+    //the end point of an unused line touching point, false if there is none
+    auto next = [&](const Point & point, Point & end)
+    {
+        auto range = ends.equal_range(hashPoint(point));
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            const Line & line = *lines[it->second];
+            if (used[it->second])
+            {
+                continue;
+            }
+            if (samePoint(line.first, point))
+            {
+                end = line.second;
+            }
+            else if (samePoint(line.second, point))
+            {
+                end = line.first;
+            }
+            else
+            {
+                continue;
+            }
+            used[it->second] = true;
+            return true;
+        }
+        return false;
+    };
+
+    //grow each chain forward from its last point, then backward from its
+    //first, the backward part is reversed into place at the end
+    std::vector<Polyline> polylines;
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        if (used[i])
+        {
+            continue;
+        }
+        used[i] = true;
+        Polyline forward;
+        forward.push_back(lines[i]->first);
+        forward.push_back(lines[i]->second);
+        Point end;
+        while (next(forward.back(), end))
+        {
+            forward.push_back(end);
+        }
+        Polyline backward;
+        backward.push_back(forward.front());
+        while (next(backward.back(), end))
+        {
+            backward.push_back(end);
+        }
+        Polyline polyline(backward.rbegin(), backward.rend() - 1);
+        polyline.insert(polyline.end(), forward.begin(), forward.end());
+        polylines.push_back(polyline);
+    }
+    return polylines;
+}
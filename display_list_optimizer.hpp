@@ -0,0 +1,62 @@
+#ifndef DISPLAY_LIST_OPTIMIZER_HPP
+#define DISPLAY_LIST_OPTIMIZER_HPP
+
+// system includes
+#include <vector>
+#include <cstddef>
+
+// module includes
+#include "display_list.hpp"
+
+// A Polyline is a chain of line segments joined end to end, every point
+// but the first is the end of one segment
+typedef PointList Polyline;
+
+// What an optimizer pass did to a display list
+struct OptimizerStats
+{
+  // atoms before and after the pass
+  size_t input;
+  size_t output;
+  // atoms dropped because an earlier atom draws exactly the same
+  size_t duplicates;
+  // lines folded into the collinear line they continue
+  size_t merged;
+  // polylines of two or more segments the remaining lines were joined into
+  size_t polylines;
+  // how long the pass took
+  double seconds;
+
+  OptimizerStats();
+
+  // output over input, 1 for an empty list
+  double ratio() const;
+};
+
+// A display list made smaller for rendering and export. graphics draws
+// the same picture, polylines is the lines of graphics joined up for
+// writers that can draw a chain of segments as one path.
+struct OptimizedDisplayList
+{
+  DisplayList graphics;
+  std::vector<Polyline> polylines;
+  OptimizerStats stats;
+};
+
+// Optimize a display list in three steps:
+// - atoms equal to an earlier atom (see sameGeometry) are dropped, the
+//   first of each keeps its place in drawing order
+// - a line that starts where the line before it ends and goes on in the
+//   same direction is merged into it
+// - the remaining lines are joined into polylines wherever one ends where
+//   another starts or ends
+// Drawing an atom twice, or the joint of two lines, only darkens the
+// antialiased pixels drawn over, so apart from those the optimized list
+// draws the same pixels.
+OptimizedDisplayList optimizeDisplayList(const DisplayList & graphics);
+
+// join the lines of a display list into polylines, in drawing order, a
+// line that touches no other is a polyline of its own
+std::vector<Polyline> joinPolylines(const DisplayList & graphics);
+
+#endif
@@ -4,16 +4,30 @@
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
 
 #include "interpreter_semantic_error.hpp"
+#include "numeric_array.hpp"
+#include "scene_graph.hpp"
+
+//how many frames lambdas were defined into are kept track of before the
+//first collection
+static const size_t MIN_COLLECT = 1024;
+
+//how deeply evaluations may nest. a recursive call that is not in tail
+//position takes one or two, and each takes up to 3 KB of stack in an
+//unoptimized build, so this stays inside an 8 MB stack
+static const size_t MAX_DEPTH = 2000;
 
 //this is the constructor for the environment class
 //instantiate all the procedures and expressions in the private variable map envmap
 Environment::Environment()
 {
   envmap["not"] = {ProcedureType, Expression(), &procNot};
-  envmap["and"] = {ProcedureType, Expression(), &procAnd};
-  envmap["or"] = {ProcedureType, Expression(), &procOr};
+  envmap["and"] = {ProcedureType, Expression(), NULL};
+  envmap["or"] = {ProcedureType, Expression(), NULL};
   envmap["<"] = {ProcedureType, Expression(), &procLessThan};
   envmap["<="] = {ProcedureType, Expression(), &procLessThanEq};
   envmap[">"] = {ProcedureType, Expression(), &procGreaterThan};
@@ -28,11 +42,36 @@ Environment::Environment()
   envmap["sin"] = {ProcedureType, Expression(), &procSin};
   envmap["cos"] = {ProcedureType, Expression(), &procCos};
   envmap["arctan"] = {ProcedureType, Expression(), &procArctan};
+  envmap["range"] = {ProcedureType, Expression(), &procRange};
+  envmap["linspace"] = {ProcedureType, Expression(), &procLinspace};
+  envmap["translate"] = {ProcedureType, Expression(), &procTranslate};
+  envmap["rotate"] = {ProcedureType, Expression(), &procRotate};
+  envmap["scale"] = {ProcedureType, Expression(), &procScale};
+  envmap["group"] = {ProcedureType, Expression(), &procGroup};
   envmap["begin"] = {ProcedureType, Expression(), NULL};
   envmap["if"] = {ProcedureType, Expression(), NULL};
   envmap["define"] = {ProcedureType, Expression(), NULL};
+  envmap["repeat"] = {ProcedureType, Expression(), NULL};
+  envmap["for"] = {ProcedureType, Expression(), NULL};
+  envmap["points"] = {ProcedureType, Expression(), NULL};
+  envmap["polyline"] = {ProcedureType, Expression(), NULL};
+  envmap["polygon"] = {ProcedureType, Expression(), NULL};
+  envmap["arcs"] = {ProcedureType, Expression(), NULL};
+  envmap["curve"] = {ProcedureType, Expression(), NULL};
+  envmap["lambda"] = {ProcedureType, Expression(), NULL};
+  envmap["point"] = {ProcedureType, Expression(), NULL};
+  envmap["line"] = {ProcedureType, Expression(), NULL};
+  envmap["arc"] = {ProcedureType, Expression(), NULL};
+  envmap["draw"] = {ProcedureType, Expression(), NULL};
+  envmap["layer"] = {ProcedureType, Expression(), NULL};
+  envmap["clear"] = {ProcedureType, Expression(), NULL};
   envmap["pi"] = {ExpressionType, Expression(atan2(0, -1)), NULL};
-
+  sink = nullptr;
+  cancelFlag = nullptr;
+  memo = nullptr;
+  collectAt = MIN_COLLECT;
+  depth = 0;
+  layer = DEFAULT_LAYER;
 }
 
 //this is the updateEvaluate method for the environment class
@@ -43,365 +82,532 @@ Expression Environment::updateEvaluate(Expression ast)
 	return exp; 	
 }
 
-//this is the evaluate method for the environment class
-//private method to call that evaluates the the ast
-Expression Environment::evaluate(Expression ast)
+//restores the frame of the caller when an evaluation is done or throws
+struct FrameGuard
 {
-	Expression exp; 
-	bool astCheck = false;
-	if (ast.head.type == NumberType)
-	{
-		astCheck = true;
-	}
-	else if (ast.head.type == BooleanType)
-	{
-		astCheck = true;
-	}
-	else if (ast.head.value.sym_value == "begin")
-	{
-		exp = begin(ast);
-	}
-	else if (ast.head.value.sym_value == "define")
-	{
-		exp = define(ast);
-	}
-	else if (ast.head.value.sym_value == "if")
-	{
-		exp = evaluateIf(ast);
-	}
-	else if (ast.head.value.sym_value == "point")
-	{
-		exp = makePoint(ast);
-	}
-	else if (ast.head.value.sym_value == "line")
-	{
-		exp = makeLine(ast);
-	}
-	else if (ast.head.value.sym_value == "arc")
-	{
-		exp = makeArc(ast);
-	}
-	else if (ast.head.value.sym_value == "draw")
+	std::shared_ptr<Frame> & frame;
+	std::shared_ptr<Frame> saved;
+	FrameGuard(std::shared_ptr<Frame> & current): frame(current), saved(current) {}
+	~FrameGuard() { frame = saved; }
+};
+
+//counts the evaluations under way and fails once they nest so deeply the
+//stack could run out, which would take the whole program down
+struct DepthGuard
+{
+	size_t & depth;
+	DepthGuard(size_t & current): depth(current)
 	{
-		exp = drawGUI(ast);
+		if (++depth > MAX_DEPTH)
+		{
+			--depth;
+			throw InterpreterSemanticError("Error: recursion too deep");
+		}
 	}
-	else //is not special
-	{
-		if (simpleExpression(ast))
+	~DepthGuard() { --depth; }
+};
+
+//this is the evaluate method for the environment class
+//private method to call that evaluates the the ast
+//if, begin and calls of a lambda in tail position do not nest another
+//evaluate, the loop moves on to the expression they end in, so a
+//procedure calling itself last runs in constant stack space
+Expression Environment::evaluate(const Expression & ast)
+{
+	DepthGuard nesting(depth);
+	FrameGuard guard(frame);
+	//the lambda being run, it owns the body current points into
+	std::shared_ptr<const Lambda> callee;
+	const Expression * current = &ast;
+	while (true)
+	{
+		//every step of an evaluation passes here, so this is where it can be stopped
+		if (cancelFlag && cancelFlag->load(std::memory_order_relaxed))
 		{
-			exp = simpleLogic(ast);
+			throw InterpreterSemanticError("Error: evaluation cancelled");
 		}
-		else //expression is complex
+		const Expression & exp = *current;
+		if (exp.head.type == NoneType)
 		{
-			exp = complexLogic(ast);
+			throw InterpreterSemanticError("Error invalid arguments");
+		}
+		if (exp.head.type != SymbolType)
+		{
+			return exp;
+		}
+		const Symbol & name = exp.head.value.sym_value;
+		if (name == "begin")
+		{
+			if (exp.tail.empty())
+			{
+				throw InterpreterSemanticError("Error begin needs an expression");
+			}
+			for (size_t i = 0; i + 1 < exp.tail.size(); i++)
+			{
+				evaluate(exp.tail[i]);
+			}
+			current = &exp.tail.back();
+			continue;
+		}
+		if (name == "if")
+		{
+			if (exp.tail.size() != 3)
+			{
+				throw InterpreterSemanticError("Error too many or too less arguments");
+			}
+			Expression test = evaluate(exp.tail[0]);
+			if (test.head.type != BooleanType)
+			{
+				throw InterpreterSemanticError("Error not a valid type");
+			}
+			current = &exp.tail[test.head.value.bool_value ? 1 : 2];
+			continue;
+		}
+		if (name == "and" || name == "or")
+		{
+			return shortCircuit(exp, name == "or");
+		}
+		if (name == "define")
+		{
+			return define(exp);
+		}
+		if (name == "point")
+		{
+			return makePoint(exp);
+		}
+		if (name == "line")
+		{
+			return makeLine(exp);
+		}
+		if (name == "arc")
+		{
+			return makeArc(exp);
+		}
+		if (name == "draw")
+		{
+			return drawGUI(exp);
+		}
+		if (name == "layer")
+		{
+			return selectLayer(exp);
+		}
+		if (name == "clear")
+		{
+			return clearLayer(exp);
+		}
+		if (name == "repeat")
+		{
+			return repeat(exp);
+		}
+		if (name == "for")
+		{
+			return evaluateFor(exp);
+		}
+		if (name == "lambda")
+		{
+			return makeLambda(exp);
+		}
+		if (name == "points" || name == "polyline" || name == "polygon" || name == "arcs")
+		{
+			return drawBulk(exp);
+		}
+		if (name == "curve")
+		{
+			return drawCurve(exp);
 		}
-	}
-	if (astCheck)
-	{
-		return ast;
-	}
-	return exp;
-}
 
-//this is the simpleLogic method for the environment class
-//private method that evaluates simple logic for the ast
-//i.e. tails of the ast do not have tails
-Expression Environment::simpleLogic(Expression exp)
-{
-	std::map<Symbol, EnvResult>::iterator itr;
-	itr = envmap.find(exp.head.value.sym_value);
-	Expression newExp;
-	//if you can not find the expression in the map, throw an error
-	if (itr != envmap.end())
-	{
+		//a symbol on its own is a variable
+		const Expression * value = lookup(name);
 		if (exp.tail.empty())
 		{
-			if (itr->second.type != ExpressionType)
+			if (value)
+			{
+				return *value;
+			}
+			if (envmap.find(name) != envmap.end())
 			{
 				throw InterpreterSemanticError("Error not an expression type");
 			}
-			return itr->second.exp;
+			throw InterpreterSemanticError("Error could not find procedure");
 		}
-		//make a vector of atoms and loop through the tail filling the vector
-		std::vector<Atom> args;
-		for (size_t i = 0; i < exp.tail.size(); i++)
+		if (!value)
 		{
-			Atom a;
-			if (exp.tail[i].head.type == BooleanType)
-			{	
-				a.type = BooleanType;
-				a.value.bool_value = exp.tail[i].head.value.bool_value;
-			}
-			else if (exp.tail[i].head.type == NumberType)
+			std::map<Symbol, EnvResult>::iterator itr = envmap.find(name);
+			if (itr == envmap.end() || !itr->second.proc)
 			{
-				a.type = NumberType;
-				a.value.num_value = exp.tail[i].head.value.num_value;
+				throw InterpreterSemanticError("Error could not find procedure");
 			}
-			else if (exp.tail[i].head.type == SymbolType)
-			{		
-				std::map<Symbol, EnvResult>::iterator newItr;
-				newItr = envmap.find(exp.tail[i].head.value.sym_value);
-				if (newItr == envmap.end())
-				{
-					throw InterpreterSemanticError("Error atom not defined");
-				}
-				Expression newExp = newItr->second.exp;
-				if (newExp.head.type == BooleanType)
-				{
-					a.type = BooleanType;
-					a.value.bool_value = newExp.head.value.bool_value;
-				}
-				else if (newExp.head.type == NumberType)
-				{
-					a.type = NumberType;
-					a.value.num_value = newExp.head.value.num_value;
-				}		
-			}
-			args.push_back(a);
+			return apply(exp, itr->second.proc);
 		}
-		newExp = itr->second.proc(args);		
-	}
-	else
-	{
-		throw InterpreterSemanticError("Error could not find procedure");
+		if (value->head.type != LambdaType)
+		{
+			throw InterpreterSemanticError("Error not a procedure");
+		}
+
+		//call a lambda: bind its parameters in a new frame under the one
+		//it was made in and carry on with its body
+		std::shared_ptr<const Lambda> lambda = std::static_pointer_cast<const Lambda>(value->head.value.shared_value);
+		if (exp.tail.size() != lambda->params.size())
+		{
+			throw InterpreterSemanticError("Error wrong number of arguments to a procedure");
+		}
+		std::shared_ptr<Frame> call = std::make_shared<Frame>();
+		call->bindings.reserve(lambda->params.size());
+		for (size_t i = 0; i < exp.tail.size(); i++)
+		{
+			call->bindings.push_back(std::make_pair(lambda->params[i], evaluate(exp.tail[i])));
+		}
+		call->parent = lambda->frame;
+		frame = call;
+		callee = lambda;
+		for (size_t i = 0; i + 1 < callee->body.size(); i++)
+		{
+			evaluate(callee->body[i]);
+		}
+		current = &callee->body.back();
 	}
-	return newExp;	
 }
 
-//this is the complexLogic method for the environment class
-//private method that evaluates complex logic for the ast
-//i.e. tails of the ast do have tails
-Expression Environment::complexLogic(Expression exp)
+//the builtins whose value only depends on the numbers they are given, and
+//how many they take. the memo cache knows them by their place here plus one
+struct PureBuiltin
 {
-	std::map<Symbol, EnvResult>::iterator itr;
-	itr = envmap.find(exp.head.value.sym_value);
-	Expression returnExp;
-	//if you can not find the expression in the map, throw an error
-	if (itr != envmap.end()) {
-		//make a vector of atoms and loop through the tail filling the vector
-		int size = exp.tail.size();
-		int i = 0;
-		Expression tempExp;
-		tempExp.head.type = exp.head.type;
-		tempExp.head.value.sym_value = exp.head.value.sym_value;
-		while (i < size) {
-			std::vector<Atom> args;
-			if (exp.tail[i].tail.empty()) {  //is just a number
-				Expression newExp;
-				newExp.head.type = NumberType;
-				newExp.head.value.num_value = exp.tail[i].head.value.num_value;
-				tempExp.tail.push_back(newExp);
-			}
-			else {
-				for (size_t j = 0; j < exp.tail[i].tail.size(); j++) {
-					Atom a;
-					a.type = exp.tail[i].tail[j].head.type;
-					if (exp.tail[i].tail[j].head.type == BooleanType) {	
-						a.value.bool_value = exp.tail[i].tail[j].head.value.bool_value;
-					}
-					else if (exp.tail[i].tail[j].head.type == NumberType) {
-						a.value.num_value = exp.tail[i].tail[j].head.value.num_value;
-					}
-					else if (exp.tail[i].tail[j].head.type == SymbolType) {
-						Expression newExp = simpleLogic(exp.tail[i].tail[j]);
-						a.type = NumberType;
-						a.value.num_value = newExp.head.value.num_value;
-					}
-					args.push_back(a);
-				}
-				Expression newExp;
-				std::map<Symbol, EnvResult>::iterator itr2;
-				itr2 = envmap.find(exp.tail[i].head.value.sym_value);
-				newExp = itr2->second.proc(args);
-				tempExp.tail.push_back(newExp);
+	Procedure proc;
+	size_t arity;
+};
+static const PureBuiltin PURE_BUILTINS[] = {{&procSin, 1}, {&procCos, 1}, {&procLog10, 1},
+	{&procPow, 2}, {&procArctan, 2}};
+static const size_t PURE_BUILTIN_COUNT = sizeof(PURE_BUILTINS) / sizeof(PURE_BUILTINS[0]);
+
+//the memo cache id of proc called with args, 0 if its value is not kept:
+//it is not pure or it was not given plain numbers, which may be an error
+static unsigned memoId(Procedure proc, const std::vector<Atom> & args)
+{
+	for (size_t id = 0; id < PURE_BUILTIN_COUNT; id++)
+	{
+		if (PURE_BUILTINS[id].proc != proc)
+		{
+			continue;
+		}
+		if (args.size() != PURE_BUILTINS[id].arity)
+		{
+			return 0;
+		}
+		for (size_t i = 0; i < args.size(); i++)
+		{
+			if (args[i].type != NumberType)
+			{
+				return 0;
 			}
-			i++;
 		}
-		returnExp = simpleLogic(tempExp);	
+		return unsigned(id + 1);
 	}
-	else {
-		throw InterpreterSemanticError("Error could not find procedure");
-	}
-	return returnExp;
+	return 0;
 }
 
-//this is the simpleExpression method for the environment class
-//private method that checks if the ast is simple
-bool Environment::simpleExpression(Expression exp)
+//call a builtin procedure with the values of the arguments
+Expression Environment::apply(const Expression & exp, Procedure proc)
 {
-	//if the head type isnt a symbol throw an error, meaning it is a procedure
-	if (exp.head.type != 4)
+	std::vector<Atom> args;
+	args.reserve(exp.tail.size());
+	for (size_t i = 0; i < exp.tail.size(); i++)
 	{
-		throw InterpreterSemanticError("Error invalid arguments");
+		args.push_back(evaluate(exp.tail[i]).head);
 	}
-	//as long as the expression do not have tails
-	bool simpleExpression = true;
-	for (size_t i = 0; i < exp.tail.size(); i++)
+	unsigned id = memo ? memoId(proc, args) : 0;
+	if (id == 0)
 	{
-		if (!exp.tail[i].tail.empty())
-		{
-			simpleExpression = false;
-		}
+		return proc(args);
+	}
+	double numbers[2];
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		numbers[i] = args[i].value.num_value;
 	}
-	return simpleExpression;
+	double value;
+	if (memo->find(id, numbers, args.size(), value))
+	{
+		return Expression(value);
+	}
+	Expression result = proc(args);
+	memo->insert(id, numbers, args.size(), result.head.value.num_value);
+	return result;
 }
 
-//this is the begin method for the environment class
-//method that evaluates the ast if the head is begin
-Expression Environment::begin(Expression exp)
+//the value of a variable, from the innermost frame that has it or from
+//envmap, null if there is none
+const Expression * Environment::lookup(const Symbol & name) const
 {
-	//check that begin is the head of the exp
-	if (exp.head.type != SymbolType)
+	for (const Frame * f = frame.get(); f; f = f->parent.get())
 	{
-		throw InterpreterSemanticError("Error head does not start with begin/a symbol");
+		for (size_t i = 0; i < f->bindings.size(); i++)
+		{
+			if (f->bindings[i].first == name)
+			{
+				return &f->bindings[i].second;
+			}
+		}
 	}
-	Expression returnExp;
-	Expression newExp;
-	for (size_t i = 0; i < exp.tail.size(); i++)
+	std::map<Symbol, EnvResult>::const_iterator itr = envmap.find(name);
+	if (itr != envmap.end() && itr->second.type == ExpressionType)
 	{
-		newExp = evaluate(exp.tail[i]);
-		returnExp.tail.push_back(newExp);
+		return &itr->second.exp;
 	}
-	return returnExp.tail[exp.tail.size() - 1];
+	return nullptr;
+}
 
+//whether name is a builtin procedure or special form
+bool Environment::isProcedureName(const Symbol & name) const
+{
+	std::map<Symbol, EnvResult>::const_iterator itr = envmap.find(name);
+	return itr != envmap.end() && itr->second.type == ProcedureType;
 }
 
 //this is the define method for the environment class
 //method that evaluates the ast if the head is define
-Expression Environment::define(Expression exp)
+//inside a procedure the name is only bound in the frame of the call
+Expression Environment::define(const Expression & exp)
 {
 	if (exp.tail.size() != 2) {
 		throw InterpreterSemanticError("Error too many/less arguements");
 	}	
-	if (exp.tail[0].head.type != SymbolType) {
+	if (exp.tail[0].head.type != SymbolType || !exp.tail[0].tail.empty()) {
 		throw InterpreterSemanticError("Error trying to define something that is not a symbol");
 	}
-	std::map<Symbol, EnvResult>::iterator itr;
-	itr = envmap.find(exp.tail[0].head.value.sym_value);
-	if (itr != envmap.end()) {
+	const Symbol & name = exp.tail[0].head.value.sym_value;
+	if (envmap.find(name) != envmap.end()) {
 		throw InterpreterSemanticError("Error symbol has already been defined");
 	}
-	if (!exp.tail[1].tail.empty()) {  //complex, if what you are defining is an procedure, arc, line or point
-		Expression newExp;
-		std::string newSym = exp.tail[0].head.value.sym_value;
-		if (exp.tail[1].head.value.sym_value == "arc") {
-			newExp = makeArc(exp.tail[1]);
-			envmap[newSym] = {ExpressionType, newExp, NULL};
-		}
-		else if (exp.tail[1].head.value.sym_value == "line") {
-			newExp = makeLine(exp.tail[1]);
-			envmap[newSym] = {ExpressionType, newExp, NULL};
+	if (frame) {
+		for (size_t i = 0; i < frame->bindings.size(); i++) {
+			if (frame->bindings[i].first == name) {
+				throw InterpreterSemanticError("Error symbol has already been defined");
+			}
 		}
-		else if (exp.tail[1].head.value.sym_value == "point") {
-			newExp = makePoint(exp.tail[1]);
-			envmap[newSym] = {ExpressionType, newExp, NULL};
+	}
+	Expression value = evaluate(exp.tail[1]);
+	if (value.head.type == NoneType) {
+		throw InterpreterSemanticError("Error nothing to define");
+	}
+	if (frame) {
+		frame->bindings.push_back(std::make_pair(name, value));
+		if (value.head.type == LambdaType) {
+			lambdaFrames.push_back(frame);
+			if (lambdaFrames.size() >= collectAt) {
+				collectFrames();
+			}
 		}
-		else { //procedure 
-			newExp = simpleLogic(exp.tail[1]);
-			double newVal = newExp.head.value.num_value;
-			envmap[newSym] = {ExpressionType, Expression(newVal), NULL};
+	}
+	else {
+		envmap[name] = {ExpressionType, value, NULL};
+	}
+	return value;
+}
+
+//a frame or lambda met while collecting, refs starts as its use count and
+//loses one for every reference from another frame or lambda that was met
+struct FrameNode
+{
+	long refs;
+	bool frame;
+	bool reached;
+};
+
+//a lambda defined inside a call is bound in the frame of the call and
+//keeps that frame as its own, a cycle reference counting never frees.
+//every frame and lambda reachable from the frames lambdas were defined
+//into is counted: whatever has more users than the references between
+//them is held from outside, by envmap, the frames being evaluated or a
+//value in flight. the frames not reachable from those are garbage and
+//their bindings are dropped, which breaks the cycles
+void Environment::collectFrames()
+{
+	std::vector<std::shared_ptr<Frame> > tracked;
+	for (size_t i = 0; i < lambdaFrames.size(); i++)
+	{
+		std::shared_ptr<Frame> f = lambdaFrames[i].lock();
+		if (f)
+		{
+			tracked.push_back(f);
 		}
-		itr = envmap.find(newSym);
 	}
-	else //if what you are defining is just a number or boolean
+
+	std::unordered_map<const void *, FrameNode> nodes;
+	std::vector<Frame *> frames;
+	std::vector<const Lambda *> lambdas;
+	auto meetFrame = [&](const std::shared_ptr<Frame> & f)
+	{
+		if (f && nodes.insert(std::make_pair(f.get(), FrameNode{f.use_count(), true, false})).second)
+		{
+			frames.push_back(f.get());
+		}
+	};
+	auto meetLambda = [&](const std::shared_ptr<const void> & l)
 	{
-		std::string newSym = exp.tail[0].head.value.sym_value;
-		std::map<Symbol, EnvResult>::iterator newItr;
-		newItr = envmap.find(exp.tail[1].head.value.sym_value);
-		if (newItr != envmap.end()) {
-			envmap[newSym] = {ExpressionType, newItr->second.exp, NULL};
+		if (l && nodes.insert(std::make_pair(l.get(), FrameNode{l.use_count(), false, false})).second)
+		{
+			lambdas.push_back(static_cast<const Lambda *>(l.get()));
 		}
-		else if (exp.tail[1].head.type == BooleanType) { //if a boolean
-			bool newB = exp.tail[1].head.value.bool_value;
-			envmap[newSym] = {ExpressionType, Expression(newB), NULL};		
+	};
+	for (size_t i = 0; i < tracked.size(); i++)
+	{
+		meetFrame(tracked[i]);
+		//tracked holds one of its users
+		nodes[tracked[i].get()].refs--;
+	}
+	for (size_t f = 0, l = 0; f < frames.size() || l < lambdas.size();)
+	{
+		if (f < frames.size())
+		{
+			Frame * current = frames[f++];
+			meetFrame(current->parent);
+			for (size_t i = 0; i < current->bindings.size(); i++)
+			{
+				if (current->bindings[i].second.head.type == LambdaType)
+				{
+					meetLambda(current->bindings[i].second.head.value.shared_value);
+				}
+			}
 		}
-		else  { //a number
-			double newVal = exp.tail[1].head.value.num_value;
-			envmap[newSym] = {ExpressionType, Expression(newVal), NULL};
+		else
+		{
+			meetFrame(lambdas[l++]->frame);
 		}
-		itr = envmap.find(newSym);
 	}
-	return itr->second.exp;
-}
-
 
-Expression Environment::evaluateIf(Expression exp)
-{
-	Expression newExp;
-	if (simpleExpression(exp)) //if true or false
+	//take off the references from inside
+	for (size_t f = 0; f < frames.size(); f++)
 	{
-		if (exp.tail[0].head.type != BooleanType) {
-			throw InterpreterSemanticError("Error not a valid type");
+		if (frames[f]->parent)
+		{
+			nodes[frames[f]->parent.get()].refs--;
+		}
+		for (size_t i = 0; i < frames[f]->bindings.size(); i++)
+		{
+			const Atom & value = frames[f]->bindings[i].second.head;
+			if (value.type == LambdaType && value.value.shared_value)
+			{
+				nodes[value.value.shared_value.get()].refs--;
+			}
 		}
-		if (exp.tail.size() != 3) {
-			throw InterpreterSemanticError("Error too many or too less arguments");
-		} 		
-		newExp.head.type = NumberType;
-		if (exp.tail[0].head.value.bool_value) {
-			newExp.head.value.num_value = exp.tail[1].head.value.num_value;
+	}
+	for (size_t l = 0; l < lambdas.size(); l++)
+	{
+		if (lambdas[l]->frame)
+		{
+			nodes[lambdas[l]->frame.get()].refs--;
 		}
-		else {
-			newExp.head.value.num_value = exp.tail[2].head.value.num_value;
-		}		
 	}
-	else //comparators
+
+	//mark what the outside holds and everything it reaches
+	std::vector<const void *> pending;
+	for (std::unordered_map<const void *, FrameNode>::iterator i = nodes.begin(); i != nodes.end(); ++i)
 	{
-		if (exp.tail.size() != 3) {
-			throw InterpreterSemanticError("Error too many or too less arguments");
+		if (i->second.refs > 0)
+		{
+			i->second.reached = true;
+			pending.push_back(i->first);
 		}
-		Expression returnExp; 
-		for (size_t i = 0; i < exp.tail.size(); i++) {  //loop through the tail and simplify the expression
-			if (!exp.tail[i].tail.empty()) {
-				newExp = simpleLogic(exp.tail[i]);
-				returnExp.tail.push_back(newExp);
-			}
-			else {
-				returnExp.tail.push_back(exp.tail[i]);
-			}
+	}
+	auto reach = [&](const void * node)
+	{
+		FrameNode & n = nodes[node];
+		if (!n.reached)
+		{
+			n.reached = true;
+			pending.push_back(node);
 		}
-		if (returnExp.tail[0].head.value.bool_value) { //depending on bool value of first tail, return second or third tail
-			std::map<Symbol, EnvResult>::iterator itr;
-			if (returnExp.tail[1].head.type == SymbolType) {
-				itr = envmap.find(returnExp.tail[1].head.value.sym_value);
-				Expression e = itr->second.exp;
-				return e;
+	};
+	while (!pending.empty())
+	{
+		const void * node = pending.back();
+		pending.pop_back();
+		if (nodes[node].frame)
+		{
+			const Frame * f = static_cast<const Frame *>(node);
+			if (f->parent)
+			{
+				reach(f->parent.get());
 			}
-			if (returnExp.tail[1].head.type == BooleanType || returnExp.tail[1].head.type == NumberType) {
-				return returnExp.tail[1];
+			for (size_t i = 0; i < f->bindings.size(); i++)
+			{
+				const Atom & value = f->bindings[i].second.head;
+				if (value.type == LambdaType && value.value.shared_value)
+				{
+					reach(value.value.shared_value.get());
+				}
 			}
+		}
+		else if (static_cast<const Lambda *>(node)->frame)
+		{
+			reach(static_cast<const Lambda *>(node)->frame.get());
+		}
+	}
 
+	//the bindings are dropped only once nothing above is looked at, since
+	//that frees the frames and lambdas of the cycles
+	std::vector<std::vector<std::pair<Symbol, Expression> > > garbage;
+	lambdaFrames.clear();
+	for (size_t f = 0; f < frames.size(); f++)
+	{
+		if (!nodes[frames[f]].reached)
+		{
+			garbage.push_back(std::vector<std::pair<Symbol, Expression> >());
+			garbage.back().swap(frames[f]->bindings);
 		}
-		else {  //is false
-			std::map<Symbol, EnvResult>::iterator itr;
-			if (returnExp.tail[2].head.type == SymbolType) {
-				itr = envmap.find(returnExp.tail[2].head.value.sym_value);
-				Expression e = itr->second.exp;
-				return e;
-			}
-			if (returnExp.tail[2].head.type == BooleanType || returnExp.tail[2].head.type == NumberType) {
-				return returnExp.tail[2];
-			}
+	}
+	for (size_t i = 0; i < tracked.size(); i++)
+	{
+		if (nodes[tracked[i].get()].reached)
+		{
+			lambdaFrames.push_back(tracked[i]);
 		}
 	}
-	return newExp;
+	collectAt = std::max(MIN_COLLECT, 2 * lambdaFrames.size());
+	garbage.clear();
+	tracked.clear();
+}
+
+//(lambda (params ...) body ...) makes a procedure of the body that runs
+//with the params bound to the arguments it is called with, and sees the
+//variables where it was made
+Expression Environment::makeLambda(const Expression & exp)
+{
+	if (exp.tail.size() < 2 || exp.tail[0].head.type != SymbolType) {
+		throw InterpreterSemanticError("Error: lambda takes a list of parameters and a body");
+	}
+	std::shared_ptr<Lambda> lambda = std::make_shared<Lambda>();
+	//the parser keeps the first name of the list as its head
+	const Expression & params = exp.tail[0];
+	lambda->params.push_back(params.head.value.sym_value);
+	for (size_t i = 0; i < params.tail.size(); i++) {
+		if (params.tail[i].head.type != SymbolType || !params.tail[i].tail.empty()) {
+			throw InterpreterSemanticError("Error: lambda takes a list of parameters and a body");
+		}
+		lambda->params.push_back(params.tail[i].head.value.sym_value);
+	}
+	for (size_t i = 0; i < lambda->params.size(); i++) {
+		if (isProcedureName(lambda->params[i]) ||
+		    std::count(lambda->params.begin(), lambda->params.begin() + i, lambda->params[i])) {
+			throw InterpreterSemanticError("Error: lambda parameters must be distinct names that are not procedures");
+		}
+	}
+	lambda->body.assign(exp.tail.begin() + 1, exp.tail.end());
+	lambda->frame = frame;
+	Expression result;
+	result.head.type = LambdaType;
+	result.head.value.shared_value = lambda;
+	return result;
 }
 
 //P3 method definitions
-Expression Environment::drawGUI(Expression exp) {
+Expression Environment::drawGUI(const Expression & exp) {
 	if (exp.head.type != SymbolType) {
 		throw InterpreterSemanticError("Error head does not start with draw/a symbol");
 	}
-	Expression drawExp, newExp;
-	std::map<Symbol, EnvResult>::iterator itr;
+	Expression drawExp;
 	for (size_t i = 0; i < exp.tail.size(); i++) {
-		itr = envmap.find(exp.tail[i].head.value.sym_value);
-		if (itr == envmap.end()) {
-			newExp = evaluate(exp.tail[i]);
-		}
-		else {
-			newExp = itr->second.exp;
-		}
-		drawExp.tail.push_back(newExp);
+		drawExp.tail.push_back(evaluate(exp.tail[i]));
 	}
 	for (size_t i = 0; i < drawExp.tail.size(); i++) {  //create the vector of atoms, graphics
 		Atom a;
@@ -443,161 +649,488 @@ Expression Environment::drawGUI(Expression exp) {
     		a.value.arc_value.span = angle; 
     		a.type = ArcType;
 		}
-		graphics.push_back(a);
-	}	
-	Expression returnExp;
-	return returnExp;					
+		else if (drawExp.tail[i].head.type == PolylineType || drawExp.tail[i].head.type == PolygonType) {
+			a.value.shared_value = drawExp.tail[i].head.value.shared_value;
+			a.type = drawExp.tail[i].head.type;
+		}
+		else if (drawExp.tail[i].head.type == GroupType) {
+			a.value.shared_value = drawExp.tail[i].head.value.shared_value;
+			a.type = GroupType;
+		}
+		else {
+			continue;
+		}
+		addGraphics(&a, 1);
+	}	
+	Expression returnExp;
+	return returnExp;					
+}
+
+//hands atoms to the sink, or keeps them on the current layer
+void Environment::addGraphics(const Atom * atoms, size_t count)
+{
+	if (sink)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			sink->addGraphic(atoms[i]);
+		}
+		return;
+	}
+	size_t index = std::find(layerNames.begin(), layerNames.end(), layer) - layerNames.begin();
+	if (index == layerNames.size())
+	{
+		layerNames.push_back(layer);
+	}
+	graphics.insert(graphics.end(), atoms, atoms + count);
+	graphicsLayers.insert(graphicsLayers.end(), count, index);
+}
+
+//(points xs ys), (polyline xs ys), (polygon xs ys) and (arcs cxs cys sxs
+//sys spans) draw a whole batch at once from lists of coordinates, a number
+//goes with every element. polyline joins its points with lines in order
+//and polygon closes them back to the first, each is one atom holding all
+//of its vertices. the atoms are made straight from the list data in
+//chunks, no expression is built for any of them.
+//(polyline p1 p2 ...) and (polygon p1 p2 ...) of points draw nothing, they
+//make a value to draw later like line and arc do
+Expression Environment::drawBulk(const Expression & exp)
+{
+	const Symbol & name = exp.head.value.sym_value;
+	enum {Points, Polyline, Polygon, Arcs} kind = name == "points" ? Points : name == "polyline" ? Polyline
+		: name == "polygon" ? Polygon : Arcs;
+	size_t arity = kind == Arcs ? 5 : 2;
+
+	//the values are kept so the list data stays alive
+	std::vector<Expression> values;
+	for (size_t i = 0; i < exp.tail.size(); i++)
+	{
+		values.push_back(evaluate(exp.tail[i]));
+	}
+	if ((kind == Polyline || kind == Polygon) && !values.empty() && values[0].head.type == PointType)
+	{
+		if (values.size() < 2)
+		{
+			throw InterpreterSemanticError("Error: " + name + " needs at least two points");
+		}
+		std::shared_ptr<PointList> vertices = std::make_shared<PointList>();
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (values[i].head.type != PointType)
+			{
+				throw InterpreterSemanticError("Error: " + name + " takes points or lists of coordinates");
+			}
+			vertices->push_back(values[i].head.value.point_value);
+		}
+		return Expression(std::shared_ptr<const PointList>(vertices), kind == Polygon);
+	}
+	if (values.size() != arity)
+	{
+		throw InterpreterSemanticError("Error: " + name + " takes " + (arity == 5 ?
+			"lists of centers, starts and spans" : "lists of x and y coordinates"));
+	}
+
+	//a number is read with a stride of 0 so it repeats for every element
+	const double * column[5];
+	size_t stride[5];
+	size_t count = 1;
+	bool anyList = false;
+	for (size_t i = 0; i < arity; i++)
+	{
+		const Atom & atom = values[i].head;
+		if (atom.type == ListType)
+		{
+			size_t n = atom.list().size();
+			if (anyList && n != count)
+			{
+				throw InterpreterSemanticError("Error: lists must have the same length");
+			}
+			count = n;
+			anyList = true;
+		}
+		else if (atom.type != NumberType)
+		{
+			throw InterpreterSemanticError("Error not a NumberType");
+		}
+	}
+	for (size_t i = 0; i < arity; i++)
+	{
+		const Atom & atom = values[i].head;
+		column[i] = atom.type == ListType ? atom.list().data() : &atom.value.num_value;
+		stride[i] = atom.type == ListType ? 1 : 0;
+	}
+
+	if (kind == Polyline || kind == Polygon)
+	{
+		//the same as when it is given points
+		if (count < 2)
+		{
+			throw InterpreterSemanticError("Error: " + name + " needs at least two points");
+		}
+		std::shared_ptr<PointList> vertices = std::make_shared<PointList>(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			(*vertices)[i].x = column[0][i * stride[0]];
+			(*vertices)[i].y = column[1][i * stride[1]];
+		}
+		Atom a = Expression(std::shared_ptr<const PointList>(vertices), kind == Polygon).head;
+		addGraphics(&a, 1);
+		return Expression();
+	}
+
+	size_t atoms = count;
+	if (!sink)
+	{
+		graphics.reserve(graphics.size() + atoms);
+		graphicsLayers.reserve(graphicsLayers.size() + atoms);
+	}
+	const size_t CHUNK = 4096;
+	std::vector<Atom> chunk(std::min(atoms, CHUNK));
+	for (size_t start = 0; start < atoms; start += CHUNK)
+	{
+		if (cancelFlag && cancelFlag->load(std::memory_order_relaxed))
+		{
+			throw InterpreterSemanticError("Error: evaluation cancelled");
+		}
+		size_t end = std::min(atoms, start + CHUNK);
+		for (size_t i = start; i < end; i++)
+		{
+			Atom & a = chunk[i - start];
+			if (kind == Points)
+			{
+				a.type = PointType;
+				a.value.point_value.x = column[0][i * stride[0]];
+				a.value.point_value.y = column[1][i * stride[1]];
+			}
+			else
+			{
+				a.type = ArcType;
+				a.value.arc_value.center.x = column[0][i * stride[0]];
+				a.value.arc_value.center.y = column[1][i * stride[1]];
+				a.value.arc_value.start.x = column[2][i * stride[2]];
+				a.value.arc_value.start.y = column[3][i * stride[3]];
+				a.value.arc_value.span = column[4][i * stride[4]];
+			}
+		}
+		addGraphics(chunk.data(), end - start);
+	}
+	return Expression();
+}
+
+//how a curve is sampled: it starts out as CURVE_SEGMENTS even pieces and
+//each piece is halved at most CURVE_DEPTH times
+static const int CURVE_SEGMENTS = 16;
+static const int CURVE_DEPTH = 16;
+
+//how far p is from the line through a and b
+static Number chordError(const Point & p, const Point & a, const Point & b)
+{
+	Number dx = b.x - a.x, dy = b.y - a.y;
+	Number length = std::sqrt(dx * dx + dy * dy);
+	if (length == 0)
+	{
+		return std::sqrt((p.x - a.x) * (p.x - a.x) + (p.y - a.y) * (p.y - a.y));
+	}
+	return std::fabs(dx * (p.y - a.y) - dy * (p.x - a.x)) / length;
+}
+
+//(curve f t0 t1 tolerance) draws the points f gives for t from t0 to t1
+//as one polyline. a piece is halved until the point f gives in its middle is
+//within tolerance of its chord, so flat stretches take few lines and
+//tight bends many. f is called straight from here in a frame that is
+//reused for every call unless f keeps it
+Expression Environment::drawCurve(const Expression & exp)
+{
+	if (exp.tail.size() != 4)
+	{
+		throw InterpreterSemanticError("Error: curve takes a procedure, t0, t1 and a tolerance");
+	}
+	Expression f = evaluate(exp.tail[0]);
+	if (f.head.type != LambdaType || f.head.lambda().params.size() != 1)
+	{
+		throw InterpreterSemanticError("Error: curve needs a procedure of one parameter");
+	}
+	Number t0 = loopBound(exp.tail[1], "Error: curve bounds must be numbers");
+	Number t1 = loopBound(exp.tail[2], "Error: curve bounds must be numbers");
+	Number tolerance = loopBound(exp.tail[3], "Error: curve tolerance must be a positive number");
+	if (tolerance <= 0)
+	{
+		throw InterpreterSemanticError("Error: curve tolerance must be a positive number");
+	}
+
+	const Lambda & lambda = f.head.lambda();
+	std::shared_ptr<Frame> call;
+	auto sample = [&](Number t)
+	{
+		if (!call || call.use_count() > 1)
+		{
+			call = std::make_shared<Frame>();
+			call->parent = lambda.frame;
+		}
+		call->bindings.assign(1, std::make_pair(lambda.params[0], Expression(t)));
+		FrameGuard guard(frame);
+		frame = call;
+		Expression result;
+		for (size_t i = 0; i < lambda.body.size(); i++)
+		{
+			result = evaluate(lambda.body[i]);
+		}
+		if (result.head.type != PointType)
+		{
+			throw InterpreterSemanticError("Error: curve procedure must give a point");
+		}
+		return result.head.value.point_value;
+	};
+
+	std::shared_ptr<PointList> vertices = std::make_shared<PointList>();
+	std::function<void(Number, const Point &, Number, const Point &, int)> subdivide;
+	subdivide = [&](Number a, const Point & pa, Number b, const Point & pb, int depth)
+	{
+		Number m = (a + b) / 2;
+		Point pm = sample(m);
+		if (depth < CURVE_DEPTH && chordError(pm, pa, pb) > tolerance)
+		{
+			subdivide(a, pa, m, pm, depth + 1);
+			subdivide(m, pm, b, pb, depth + 1);
+		}
+		else
+		{
+			vertices->push_back(pm);
+			vertices->push_back(pb);
+		}
+	};
+	Point previous = sample(t0);
+	vertices->push_back(previous);
+	for (int i = 1; i <= CURVE_SEGMENTS; i++)
+	{
+		Number t = i == CURVE_SEGMENTS ? t1 : t0 + (t1 - t0) * i / CURVE_SEGMENTS;
+		Point next = sample(t);
+		subdivide(t0 + (t1 - t0) * (i - 1) / CURVE_SEGMENTS, previous, t, next, 0);
+		previous = next;
+	}
+	Atom a = Expression(std::shared_ptr<const PointList>(vertices), false).head;
+	addGraphics(&a, 1);
+	return Expression();
 }
 
 //creates a point expression
-Expression Environment::makePoint(Expression exp)
+Expression Environment::makePoint(const Expression & exp)
 {
-	std::tuple<double, double> Point; 
 	if (exp.tail.size() != 2)
 	{
 		throw InterpreterSemanticError("Error invalid amount of arguments to make a point");
 	}
-	for (int i = 0; i < exp.tail.size(); i++)
+	std::tuple<double, double> point;
+	Expression x = evaluate(exp.tail[0]);
+	Expression y = evaluate(exp.tail[1]);
+	if (x.head.type != NumberType || y.head.type != NumberType)
 	{
-		std::map<Symbol, EnvResult>::iterator itr;
-		itr = envmap.find(exp.tail[i].head.value.sym_value);
-		if (itr != envmap.end()) //if the x or y coordinate is a procedure type
-		{
-			Expression newExp = simpleLogic(exp.tail[i]);
-			if (i == 0)
-			{
-				std::get<0>(Point) = newExp.head.value.num_value;
-			}
-			else if (i == 1)
-			{
-				std::get<1>(Point) = newExp.head.value.num_value;
-			}	
-		}
-		else //just a number
-		{
-			if (i == 0)
-			{
-				std::get<0>(Point) = exp.tail[i].head.value.num_value;
-			}
-			else if (i == 1)
-			{
-				std::get<1>(Point) = exp.tail[i].head.value.num_value;
-			}
-			
-		}
+		throw InterpreterSemanticError("Error point must be made of numbers");
+	}
+	std::get<0>(point) = x.head.value.num_value;
+	std::get<1>(point) = y.head.value.num_value;
+	return Expression(point);
+}
+
+//evaluates an argument that has to be a point
+Point Environment::pointArgument(const Expression & exp, const char * error)
+{
+	Expression value = evaluate(exp);
+	if (value.head.type != PointType)
+	{
+		throw InterpreterSemanticError(error);
 	}
-	//make the new point
-	Expression pointExp = Expression(Point);
-	return pointExp;
+	return value.head.value.point_value;
 }
 
 //creates a line expression
-Expression Environment::makeLine(Expression exp)
+Expression Environment::makeLine(const Expression & exp)
 {
-	std::tuple<double, double> Point1; 
-	std::tuple<double, double> Point2; 
 	if (exp.tail.size() != 2)
 	{
 		throw InterpreterSemanticError("Error invalid amount of arguments to make a line");
 	}
-	for (int i = 0; i < exp.tail.size(); i++)
+	Point first = pointArgument(exp.tail[0], "Error Line must be made of points");
+	Point second = pointArgument(exp.tail[1], "Error Line must be made of points");
+	return Expression(std::make_tuple(first.x, first.y), std::make_tuple(second.x, second.y));
+}
+
+//creates an arc expression
+Expression Environment::makeArc(const Expression & exp)
+{
+	if (exp.tail.size() != 3) {
+		throw InterpreterSemanticError("Error invalid amount of arguments to make an arc");
+	}
+	Point center = pointArgument(exp.tail[0], "Error Arc must start with two points");
+	Point start = pointArgument(exp.tail[1], "Error Arc must start with two points");
+	//an undefined name as the span has always been taken as no angle
+	const Expression & span = exp.tail[2];
+	if (span.head.type == SymbolType && span.tail.empty() && !lookup(span.head.value.sym_value)
+	    && envmap.find(span.head.value.sym_value) == envmap.end()) {
+		return Expression(std::make_tuple(center.x, center.y), std::make_tuple(start.x, start.y), 0.);
+	}
+	Expression angle = evaluate(span);
+	if (angle.head.type != NumberType) {
+		throw InterpreterSemanticError("Error Arc span must be a number");
+	}
+	return Expression(std::make_tuple(center.x, center.y), std::make_tuple(start.x, start.y), angle.head.value.num_value);
+}
+
+//(layer name) puts everything drawn after it on the named layer
+Expression Environment::selectLayer(const Expression & exp)
+{
+	if (exp.tail.size() != 1 || exp.tail[0].head.type != SymbolType || !exp.tail[0].tail.empty())
+	{
+		throw InterpreterSemanticError("Error: layer takes one name");
+	}
+	layer = exp.tail[0].head.value.sym_value;
+	if (sink)
+	{
+		sink->setLayer(layer);
+	}
+	return Expression();
+}
+
+//(clear) takes back everything drawn so far, (clear name) only what is
+//on the named layer
+Expression Environment::clearLayer(const Expression & exp)
+{
+	std::string name;
+	if (exp.tail.size() == 1 && exp.tail[0].head.type == SymbolType && exp.tail[0].tail.empty())
+	{
+		name = exp.tail[0].head.value.sym_value;
+	}
+	else if (!exp.tail.empty())
 	{
-		if (exp.tail[i].head.value.sym_value == "point")
+		throw InterpreterSemanticError("Error: clear takes at most one layer name");
+	}
+	if (sink)
+	{
+		if (!sink->clearLayer(name))
 		{
-			Expression pointExp = makePoint(exp.tail[i]); 
-			if (i == 0)
-			{
-				std::get<0>(Point1) = pointExp.head.value.point_value.x;
-				std::get<1>(Point1) = pointExp.head.value.point_value.y;
-			}
-			else if (i == 1)
-			{
-				std::get<0>(Point2) = pointExp.head.value.point_value.x;
-				std::get<1>(Point2) = pointExp.head.value.point_value.y;
-			}
+			throw InterpreterSemanticError("Error: this output cannot clear a single layer");
 		}
-		else if (exp.tail[i].head.type == SymbolType)
+	}
+	else if (name.empty())
+	{
+		clearGraphics();
+	}
+	else
+	{
+		size_t index = std::find(layerNames.begin(), layerNames.end(), name) - layerNames.begin();
+		size_t kept = 0;
+		for (size_t i = 0; i < graphics.size(); i++)
 		{
-			std::map<Symbol, EnvResult>::iterator itr;
-			itr = envmap.find(exp.tail[i].head.value.sym_value);
-			Expression lineExp = itr->second.exp;
-			if (i == 0)
-			{
-				std::get<0>(Point1) = lineExp.head.value.point_value.x;
-				std::get<1>(Point1) = lineExp.head.value.point_value.y;
-			}
-			else if (i == 1)
+			if (graphicsLayers[i] != index)
 			{
-				std::get<0>(Point2) = lineExp.head.value.point_value.x;
-				std::get<1>(Point2) = lineExp.head.value.point_value.y;
+				graphics[kept] = graphics[i];
+				graphicsLayers[kept] = graphicsLayers[i];
+				kept++;
 			}
 		}
-		else
+		graphics.resize(kept);
+		graphicsLayers.resize(kept);
+	}
+	return Expression();
+}
+
+//evaluate a count or bound of a loop, it has to come out a number
+Number Environment::loopBound(const Expression & exp, const char * error)
+{
+	Expression value = evaluate(exp);
+	if (value.head.type != NumberType || !std::isfinite(value.head.value.num_value))
+	{
+		throw InterpreterSemanticError(error);
+	}
+	return value.head.value.num_value;
+}
+
+//(and ...) and (or ...) evaluate their operands left to right and stop at
+//the first one that decides the value, false for and, true for or. the
+//operands after it are never evaluated, so they can guard work that is
+//only wanted sometimes
+Expression Environment::shortCircuit(const Expression & exp, bool decisive)
+{
+	for (size_t i = 0; i < exp.tail.size(); i++)
+	{
+		Expression operand = evaluate(exp.tail[i]);
+		if (operand.head.type != BooleanType)
+		{
+			throw InterpreterSemanticError("Error not a BooleanType");
+		}
+		if (operand.head.value.bool_value == decisive)
 		{
-			throw InterpreterSemanticError("Error Line must be made of points");
+			return Expression(decisive);
 		}
 	}
-	Expression lineExp = Expression(Point1, Point2);
-	return lineExp;
+	return Expression(!decisive);
 }
 
-//creates an arc expression
-Expression Environment::makeArc(Expression exp)
+//(repeat n body ...) evaluates the body n times, the value is the last
+//one the body had
+Expression Environment::repeat(const Expression & exp)
 {
-	std::tuple<double, double> Point1; 
-	std::tuple<double, double> Point2; 
-	double angle = 0;
-	if (exp.tail.size() != 3) {
-		throw InterpreterSemanticError("Error invalid amount of arguments to make an arc");
+	if (exp.tail.size() < 2)
+	{
+		throw InterpreterSemanticError("Error: repeat takes a count and a body");
 	}
-	for (int i = 0; i < exp.tail.size(); i++)
+	Number count = loopBound(exp.tail[0], "Error: repeat count must be a number");
+	if (count < 0 || count != std::floor(count))
 	{
-		std::map<Symbol, EnvResult>::iterator itr;
-		itr = envmap.find(exp.tail[i].head.value.sym_value);
-		if (itr != envmap.end()) //a part of the formula is a symbol
+		throw InterpreterSemanticError("Error: repeat count must be a whole number");
+	}
+	Expression returnExp;
+	for (Number n = 0; n < count; n++)
+	{
+		for (size_t i = 1; i < exp.tail.size(); i++)
 		{
-			Expression pointExp = itr->second.exp;
-			if (i == 0) {
-				std::get<0>(Point1) = pointExp.head.value.point_value.x;
-				std::get<1>(Point1) = pointExp.head.value.point_value.y;
-			}
-			else if (i == 1) {
-				std::get<0>(Point2) = pointExp.head.value.point_value.x;
-				std::get<1>(Point2) = pointExp.head.value.point_value.y;
-			}
-			else if (i == 2) {
-				Expression newExp;
-				if (simpleExpression(exp.tail[i]))
-				{
-					newExp = simpleLogic(exp.tail[i]);
-				}
-				else //expression is complex
-				{
-					newExp = complexLogic(exp.tail[i]);
-				}
-				angle = newExp.head.value.num_value;
-			}
+			returnExp = evaluate(exp.tail[i]);
 		}
-		else
+	}
+	return returnExp;
+}
+
+//(for i from to step body ...) evaluates the body with i bound to from,
+//from + step and so on while it has not reached to. i lives in a frame of
+//its own that only the loop sees, and only its value changes between
+//iterations
+Expression Environment::evaluateFor(const Expression & exp)
+{
+	if (exp.tail.size() < 5 || exp.tail[0].head.type != SymbolType || !exp.tail[0].tail.empty())
+	{
+		throw InterpreterSemanticError("Error: for takes a variable, from, to, step and a body");
+	}
+	const Symbol & name = exp.tail[0].head.value.sym_value;
+	if (isProcedureName(name))
+	{
+		throw InterpreterSemanticError("Error: for cannot bind a procedure name");
+	}
+	Number from = loopBound(exp.tail[1], "Error: for bounds must be numbers");
+	Number to = loopBound(exp.tail[2], "Error: for bounds must be numbers");
+	Number step = loopBound(exp.tail[3], "Error: for step must be a number");
+	if (step == 0)
+	{
+		throw InterpreterSemanticError("Error: for step must not be zero");
+	}
+
+	//every value comes from the iteration count, so adding up a step like
+	//0.1 never drifts past the bound
+	Number count = std::max(std::ceil((to - from) / step), 0.);
+	FrameGuard guard(frame);
+	std::shared_ptr<Frame> loop = std::make_shared<Frame>();
+	loop->bindings.push_back(std::make_pair(name, Expression(from)));
+	loop->parent = frame;
+	frame = loop;
+	Expression returnExp;
+	for (Number n = 0; n < count; n++)
+	{
+		loop->bindings[0].second.head.value.num_value = from + n * step;
+		for (size_t i = 4; i < exp.tail.size(); i++)
 		{
-			if (exp.tail[i].head.value.sym_value == "point") {
-				Expression pointExp = makePoint(exp.tail[i]); 
-				if (i == 0) {
-					std::get<0>(Point1) = pointExp.head.value.point_value.x;
-					std::get<1>(Point1) = pointExp.head.value.point_value.y;
-				}
-				else if (i == 1) {
-					std::get<0>(Point2) = pointExp.head.value.point_value.x;
-					std::get<1>(Point2) = pointExp.head.value.point_value.y;
-				}
-			}
-			else if (i == 2) {
-				angle = exp.tail[i].head.value.num_value;
-			}
+			returnExp = evaluate(exp.tail[i]);
 		}
 	}
-	Expression arcExp = Expression(Point1, Point2, angle);
-	return arcExp;
+	return returnExp;
 }
 
 std::vector<Atom> Environment::getGraphics()
@@ -605,12 +1138,37 @@ std::vector<Atom> Environment::getGraphics()
 	return graphics;
 }
 
+void Environment::clearGraphics()
+{
+	graphics.clear();
+	graphicsLayers.clear();
+}
+
+void Environment::setGraphicsSink(GraphicsSink * graphicsSink)
+{
+	sink = graphicsSink;
+}
+
+void Environment::setCancelFlag(const std::atomic<bool> * flag)
+{
+	cancelFlag = flag;
+}
+
+void Environment::setMemoCache(MemoCache * cache)
+{
+	memo = cache;
+}
+
 void Environment::reset()
 {
+	clearGraphics();
+	layerNames.clear();
+	layer = DEFAULT_LAYER;
 	envmap.clear();
+	collectFrames();
 	envmap["not"] = {ProcedureType, Expression(), &procNot};
- 	envmap["and"] = {ProcedureType, Expression(), &procAnd};
-  	envmap["or"] = {ProcedureType, Expression(), &procOr};
+ 	envmap["and"] = {ProcedureType, Expression(), NULL};
+  	envmap["or"] = {ProcedureType, Expression(), NULL};
   	envmap["<"] = {ProcedureType, Expression(), &procLessThan};
   	envmap["<="] = {ProcedureType, Expression(), &procLessThanEq};
   	envmap[">"] = {ProcedureType, Expression(), &procGreaterThan};
@@ -625,10 +1183,100 @@ void Environment::reset()
   	envmap["sin"] = {ProcedureType, Expression(), &procSin};
   	envmap["cos"] = {ProcedureType, Expression(), &procCos};
   	envmap["arctan"] = {ProcedureType, Expression(), &procArctan};
+  	envmap["range"] = {ProcedureType, Expression(), &procRange};
+  	envmap["linspace"] = {ProcedureType, Expression(), &procLinspace};
+  	envmap["translate"] = {ProcedureType, Expression(), &procTranslate};
+  	envmap["rotate"] = {ProcedureType, Expression(), &procRotate};
+  	envmap["scale"] = {ProcedureType, Expression(), &procScale};
+  	envmap["group"] = {ProcedureType, Expression(), &procGroup};
   	envmap["pi"] = {ExpressionType, Expression(atan2(0, -1)), NULL};
   	envmap["begin"] = {ProcedureType, Expression(), NULL};
   	envmap["if"] = {ProcedureType, Expression(), NULL};
   	envmap["define"] = {ProcedureType, Expression(), NULL};
+  	envmap["repeat"] = {ProcedureType, Expression(), NULL};
+  	envmap["for"] = {ProcedureType, Expression(), NULL};
+  	envmap["points"] = {ProcedureType, Expression(), NULL};
+  	envmap["polyline"] = {ProcedureType, Expression(), NULL};
+  	envmap["polygon"] = {ProcedureType, Expression(), NULL};
+  	envmap["arcs"] = {ProcedureType, Expression(), NULL};
+  	envmap["curve"] = {ProcedureType, Expression(), NULL};
+  	envmap["lambda"] = {ProcedureType, Expression(), NULL};
+  	envmap["point"] = {ProcedureType, Expression(), NULL};
+  	envmap["line"] = {ProcedureType, Expression(), NULL};
+  	envmap["arc"] = {ProcedureType, Expression(), NULL};
+  	envmap["draw"] = {ProcedureType, Expression(), NULL};
+  	envmap["layer"] = {ProcedureType, Expression(), NULL};
+  	envmap["clear"] = {ProcedureType, Expression(), NULL};
+}
+
+//the longest list range and linspace make, 1GB of numbers
+static const Number MAX_LIST_SIZE = 1 << 27;
+
+//whether any argument is a list, the arithmetic builtins then work
+//element by element
+static bool hasList(const std::vector<Atom> & args)
+{
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (args[i].type == ListType)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//the numbers of a list or number argument, n is 1 for a number
+static const double * elements(const Atom & atom, size_t & n)
+{
+	if (atom.type == ListType)
+	{
+		n = atom.list().size();
+		return atom.list().data();
+	}
+	if (atom.type != NumberType)
+	{
+		throw InterpreterSemanticError("Error not a NumberType");
+	}
+	n = 1;
+	return &atom.value.num_value;
+}
+
+//a op b element by element, a number goes with every element of a list
+static Expression listBinary(ArrayOp op, const Atom & a, const Atom & b)
+{
+	size_t na, nb;
+	const double * da = elements(a, na);
+	const double * db = elements(b, nb);
+	bool aScalar = a.type != ListType, bScalar = b.type != ListType;
+	if (!aScalar && !bScalar && na != nb)
+	{
+		throw InterpreterSemanticError("Error: lists must have the same length");
+	}
+	size_t n = aScalar ? nb : na;
+	std::shared_ptr<NumberList> out = std::make_shared<NumberList>(n);
+	arrayBinary(op, da, aScalar, db, bScalar, out->data(), n);
+	return Expression(std::shared_ptr<const NumberList>(out));
+}
+
+static Expression listUnary(ArrayFunction f, const Atom & a)
+{
+	size_t n;
+	const double * da = elements(a, n);
+	std::shared_ptr<NumberList> out = std::make_shared<NumberList>(n);
+	arrayUnary(f, da, out->data(), n);
+	return Expression(std::shared_ptr<const NumberList>(out));
+}
+
+//folds an m-ary operation over its arguments from the left
+static Expression listFold(ArrayOp op, const std::vector<Atom> & args)
+{
+	Expression result(args[0]);
+	for (size_t i = 1; i < args.size(); i++)
+	{
+		result = listBinary(op, result.head, args[i]);
+	}
+	return result;
 }
 
 //this is the procNot helper method for environment
@@ -662,50 +1310,6 @@ Expression procNot(const std::vector<Atom> & args)
 	
 }
 
-//this is the procAnd helper method for the environment
-//&& expression
-Expression procAnd(const std::vector<Atom> & args)
-{
-	Expression exp;
-	exp.head.type = BooleanType;
-	exp.head.value.bool_value = true;
-	for (size_t i = 0; i < args.size(); i++)
-	{
-		if (args[i].type != BooleanType)
-		{
-			throw InterpreterSemanticError("Error not a BooleanType");
-		}		
-		if (!args[i].value.bool_value)
-		{
-			exp.head.value.bool_value = false;
-			break;
-		}
-	}
-	return exp;
-}
-
-//this is the procOr helper method for the environment
-// || expression
-Expression procOr(const std::vector<Atom> & args)
-{
-	Expression exp;
-	exp.head.type = BooleanType;
-	exp.head.value.bool_value = false;
-	for (size_t i = 0; i < args.size(); i++)
-	{
-		if (args[i].type != BooleanType)
-		{
-			throw InterpreterSemanticError("Error not a BooleanType");
-		}	
-		if (args[i].value.bool_value)
-		{
-			exp.head.value.bool_value = true;
-			//break;
-		}
-	}
-	return exp;
-}
-
 //this is the procLessThan helper method for the environment
 //returns true if the first atom is less than the second
 Expression procLessThan(const std::vector<Atom> & args)
@@ -835,6 +1439,10 @@ Expression procEqual(const std::vector<Atom> & args)
 //adds all the atoms num_values together, m-ary
 Expression procAdd(const std::vector<Atom> & args)
 {
+	if (hasList(args))
+	{
+		return listFold(ArrayAdd, args);
+	}
 	Expression exp;
 	exp.head.type = NumberType;
 	double sum = 0;
@@ -855,6 +1463,14 @@ Expression procAdd(const std::vector<Atom> & args)
 //if size == 1, takes the negative of the num_value
 Expression procSubtractOrNeg(const std::vector<Atom> & args)
 {
+	if (hasList(args) && args.size() == 1)
+	{
+		return listUnary(ArrayNegate, args[0]);
+	}
+	if (hasList(args) && args.size() == 2)
+	{
+		return listBinary(ArraySubtract, args[0], args[1]);
+	}
 	Expression exp;
 	exp.head.type = NumberType;
 	double diff = 0;
@@ -887,6 +1503,10 @@ Expression procSubtractOrNeg(const std::vector<Atom> & args)
 //multiplies all the atoms num_values together, m-ary
 Expression procMultiply(const std::vector<Atom> & args)
 {
+	if (hasList(args))
+	{
+		return listFold(ArrayMultiply, args);
+	}
 	Expression exp;
 	exp.head.type = NumberType;
 	double sum = 1;
@@ -906,6 +1526,10 @@ Expression procMultiply(const std::vector<Atom> & args)
 //divides the first value from the second value
 Expression procDivide(const std::vector<Atom> & args)
 {
+	if (hasList(args) && args.size() == 2)
+	{
+		return listBinary(ArrayDivide, args[0], args[1]);
+	}
 	Expression exp;
 	exp.head.type = NumberType;
 	double div = 0;	
@@ -952,6 +1576,10 @@ Expression procLog10(const std::vector<Atom> & args)
 //takes the power with the base of the first value, raised to the second value
 Expression procPow(const std::vector<Atom> & args)
 {
+	if (hasList(args) && args.size() == 2)
+	{
+		return listBinary(ArrayPow, args[0], args[1]);
+	}
 	Expression exp;
 	exp.head.type = NumberType;
 	double num = 0;	
@@ -973,6 +1601,10 @@ Expression procPow(const std::vector<Atom> & args)
 
 Expression procSin(const std::vector<Atom> & args)
 {
+	if (hasList(args) && args.size() == 1)
+	{
+		return listUnary(ArraySin, args[0]);
+	}
 	Expression exp;
 	exp.head.type = NumberType;
 	double num = 0;	
@@ -983,7 +1615,7 @@ Expression procSin(const std::vector<Atom> & args)
 			throw InterpreterSemanticError("Error not a NumberType");
 		}
 		num = sin(args[0].value.num_value);
-		if (num < .001)
+		if (std::fabs(num) < .001)
 		{
 			num = 0;
 		}
@@ -998,6 +1630,10 @@ Expression procSin(const std::vector<Atom> & args)
 
 Expression procCos(const std::vector<Atom> & args)
 {
+	if (hasList(args) && args.size() == 1)
+	{
+		return listUnary(ArrayCos, args[0]);
+	}
 	Expression exp;
 	exp.head.type = NumberType;
 	double num = 0;	
@@ -1019,6 +1655,10 @@ Expression procCos(const std::vector<Atom> & args)
 
 Expression procArctan(const std::vector<Atom> & args)
 {
+	if (hasList(args) && args.size() == 2)
+	{
+		return listBinary(ArrayArctan, args[0], args[1]);
+	}
 	Expression exp;
 	exp.head.type = NumberType;
 	double num = 0;	
@@ -1038,8 +1678,143 @@ Expression procArctan(const std::vector<Atom> & args)
 	return exp;
 }
 
+//(range from to step) is the list from, from + step and so on up to but
+//not including to, like the values of a for loop
+Expression procRange(const std::vector<Atom> & args)
+{
+	if (args.size() != 3)
+	{
+		throw InterpreterSemanticError("Error too many/less arguements");
+	}
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (args[i].type != NumberType || !std::isfinite(args[i].value.num_value))
+		{
+			throw InterpreterSemanticError("Error not a NumberType");
+		}
+	}
+	Number from = args[0].value.num_value, to = args[1].value.num_value, step = args[2].value.num_value;
+	if (step == 0)
+	{
+		throw InterpreterSemanticError("Error: range step must not be zero");
+	}
+	Number count = std::max(std::ceil((to - from) / step), 0.);
+	if (count > MAX_LIST_SIZE)
+	{
+		throw InterpreterSemanticError("Error: list is too long");
+	}
+	std::shared_ptr<NumberList> values = std::make_shared<NumberList>(size_t(count));
+	arrayRange(from, step, values->data(), values->size());
+	return Expression(std::shared_ptr<const NumberList>(values));
+}
+
+//(linspace from to n) is the list of n evenly spaced numbers from from to
+//to, both included
+Expression procLinspace(const std::vector<Atom> & args)
+{
+	if (args.size() != 3)
+	{
+		throw InterpreterSemanticError("Error too many/less arguements");
+	}
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (args[i].type != NumberType || !std::isfinite(args[i].value.num_value))
+		{
+			throw InterpreterSemanticError("Error not a NumberType");
+		}
+	}
+	Number from = args[0].value.num_value, to = args[1].value.num_value, count = args[2].value.num_value;
+	if (count < 1 || count != std::floor(count))
+	{
+		throw InterpreterSemanticError("Error: linspace needs a whole number of at least one value");
+	}
+	if (count > MAX_LIST_SIZE)
+	{
+		throw InterpreterSemanticError("Error: list is too long");
+	}
+	std::shared_ptr<NumberList> values = std::make_shared<NumberList>(size_t(count));
+	arrayRange(from, count > 1 ? (to - from) / (count - 1) : 0, values->data(), values->size());
+	values->back() = count > 1 ? to : from;
+	return Expression(std::shared_ptr<const NumberList>(values));
+}
+
+//whether an atom is something draw can draw
+static bool isShape(const Atom & atom)
+{
+	return atom.type == PointType || atom.type == LineType || atom.type == ArcType
+		|| atom.type == PolylineType || atom.type == PolygonType || atom.type == GroupType;
+}
+
+//puts transform in front of the shape's own. a group keeps sharing its
+//atoms and anything else becomes a group of one, nothing is copied
+static Expression transformShape(const Atom & shape, const Transform & transform)
+{
+	if (shape.type == GroupType)
+	{
+		const Instance & instance = shape.instance();
+		return Expression(instance.group, composeTransforms(transform, instance.transform));
+	}
+	if (!isShape(shape))
+	{
+		throw InterpreterSemanticError("Error: only a point, line, arc, polyline, polygon or group can be moved");
+	}
+	return Expression(makeGroup(std::vector<Atom>(1, shape)), transform);
+}
 
+//reads the numbers in front of the shape of a transform
+static void transformArguments(const std::vector<Atom> & args, size_t numbers)
+{
+	if (args.size() != numbers + 1)
+	{
+		throw InterpreterSemanticError("Error too many/less arguements");
+	}
+	for (size_t i = 0; i < numbers; i++)
+	{
+		if (args[i].type != NumberType || !std::isfinite(args[i].value.num_value))
+		{
+			throw InterpreterSemanticError("Error not a NumberType");
+		}
+	}
+}
 
+//(translate dx dy shape) is the shape moved by dx dy
+Expression procTranslate(const std::vector<Atom> & args)
+{
+	transformArguments(args, 2);
+	Transform transform = identityTransform();
+	transform.e = args[0].value.num_value;
+	transform.f = args[1].value.num_value;
+	return transformShape(args[2], transform);
+}
 
+//(rotate angle shape) is the shape turned about the origin, counter
+//clockwise on screen like arcs
+Expression procRotate(const std::vector<Atom> & args)
+{
+	transformArguments(args, 1);
+	Number angle = args[0].value.num_value;
+	Transform transform = {cos(angle), -sin(angle), sin(angle), cos(angle), 0, 0};
+	return transformShape(args[1], transform);
+}
 
+//(scale s shape) is the shape made s times as big about the origin
+Expression procScale(const std::vector<Atom> & args)
+{
+	transformArguments(args, 1);
+	Number factor = args[0].value.num_value;
+	Transform transform = {factor, 0, 0, factor, 0, 0};
+	return transformShape(args[1], transform);
+}
 
+//(group shape ...) is one shape drawing all of its shapes in order
+Expression procGroup(const std::vector<Atom> & args)
+{
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (!isShape(args[i]))
+		{
+			throw InterpreterSemanticError("Error: a group is made of points, lines, arcs, polylines, polygons and groups");
+		}
+	}
+	return Expression(makeGroup(args), identityTransform());
+}
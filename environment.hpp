@@ -3,9 +3,34 @@
 
 // system includes
 #include <map>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <utility>
 
 // module includes
 #include "expression.hpp"
+#include "graphics_sink.hpp"
+#include "memo_cache.hpp"
+
+// A Frame holds the parameters of one procedure call, or the variable of
+// a for loop. Frames are shared, not copied: a lambda made inside a call
+// keeps the frame alive and reaches the outer ones through parent.
+struct Frame
+{
+  std::vector<std::pair<Symbol, Expression> > bindings;
+  std::shared_ptr<Frame> parent;
+};
+
+// A Lambda is a procedure made by (lambda (params ...) body ...), with
+// the frame it was made in
+struct Lambda
+{
+  std::vector<Symbol> params;
+  std::vector<Expression> body;
+  std::shared_ptr<Frame> frame;
+};
 
 class Environment{
 public:
@@ -13,6 +38,14 @@ public:
   Expression updateEvaluate(Expression ast);
   void reset();
   std::vector<Atom> getGraphics();
+  void clearGraphics();
+  // stream drawn atoms to sink instead of keeping them, nullptr keeps them
+  void setGraphicsSink(GraphicsSink * sink);
+  // evaluation stops with an error once flag is set, nullptr never stops
+  void setCancelFlag(const std::atomic<bool> * flag);
+  // remember the values of pure builtins like sin and pow in cache,
+  // nullptr always calls them
+  void setMemoCache(MemoCache * cache);
 private:
 
   // Environment is a mapping from symbols to expressions or procedures
@@ -26,30 +59,58 @@ private:
   //map
   std::map<Symbol, EnvResult> envmap;
   std::vector<Atom> graphics;
+  GraphicsSink * sink;
+
+  //the layer draw puts atoms on, and the layer of every kept atom as an
+  //index into layerNames
+  std::string layer;
+  std::vector<std::string> layerNames;
+  std::vector<size_t> graphicsLayers;
+  const std::atomic<bool> * cancelFlag;
+  MemoCache * memo;
+
+  //the frame of the call being evaluated, symbols are looked up in it and
+  //its parents before envmap. null outside of any call
+  std::shared_ptr<Frame> frame;
+
+  //frames a lambda was defined into. such a frame can be kept alive by its
+  //own binding through the frame of the lambda, so once there are
+  //collectAt of them the ones nothing else reaches are cleared
+  std::vector<std::weak_ptr<Frame> > lambdaFrames;
+  size_t collectAt;
+  void collectFrames();
+
+  //how many evaluate calls are under way
+  size_t depth;
 
   //P2 method definitions
-  Expression define(Expression exp);
-  Expression begin(Expression exp);
-  Expression evaluateIf(Expression exp);
-  Expression evaluate(Expression ast);
-  Expression simpleLogic(Expression exp);
-  Expression complexLogic(Expression exp);
-  bool simpleExpression(Expression exp);
+  Expression define(const Expression & exp);
+  Expression evaluate(const Expression & ast);
+  Expression apply(const Expression & exp, Procedure proc);
+  const Expression * lookup(const Symbol & name) const;
+  bool isProcedureName(const Symbol & name) const;
 
   //P3 method definitions
-  Expression drawGUI(Expression exp);
-  Expression makeLine(Expression exp);
-  Expression makePoint(Expression exp);
-  Expression makeArc(Expression exp);
+  Expression drawGUI(const Expression & exp);
+  Expression makeLine(const Expression & exp);
+  Expression makePoint(const Expression & exp);
+  Expression makeArc(const Expression & exp);
+  Point pointArgument(const Expression & exp, const char * error);
+  Expression selectLayer(const Expression & exp);
+  Expression clearLayer(const Expression & exp);
+  Expression shortCircuit(const Expression & exp, bool decisive);
+  Expression repeat(const Expression & exp);
+  Expression evaluateFor(const Expression & exp);
+  Expression makeLambda(const Expression & exp);
+  Expression drawBulk(const Expression & exp);
+  Expression drawCurve(const Expression & exp);
+  void addGraphics(const Atom * atoms, size_t count);
+  Number loopBound(const Expression & exp, const char * error);
 
 };
 
 Expression procNot(const std::vector<Atom> & args);
 
-Expression procAnd(const std::vector<Atom> & args);
-
-Expression procOr(const std::vector<Atom> & args);
-
 Expression procLessThan(const std::vector<Atom> & args);
 
 Expression procLessThanEq(const std::vector<Atom> & args);
@@ -78,6 +139,18 @@ Expression procCos(const std::vector<Atom> & args);
 
 Expression procArctan(const std::vector<Atom> & args);
 
+Expression procRange(const std::vector<Atom> & args);
+
+Expression procLinspace(const std::vector<Atom> & args);
+
+Expression procTranslate(const std::vector<Atom> & args);
+
+Expression procRotate(const std::vector<Atom> & args);
+
+Expression procScale(const std::vector<Atom> & args);
+
+Expression procGroup(const std::vector<Atom> & args);
+
 
 
 
@@ -1,5 +1,6 @@
 // system includes
 #include "expression.hpp"
+#include "interpreter_semantic_error.hpp"
 #include <cmath>
 #include <limits>
 #include <cctype>
@@ -31,6 +32,35 @@ Expression::Expression(const std::string & sym)
     tail.clear();
 }
 
+//list expression
+Expression::Expression(const std::shared_ptr<const NumberList> & values)
+{
+    head.type = ListType;
+    head.value.shared_value = values;
+    tail.clear();
+}
+
+//polyline or polygon expression, everything drawing an outline relies on
+//it having a first and a last vertex that differ in index
+Expression::Expression(const std::shared_ptr<const PointList> & vertices, bool closed)
+{
+    if (!vertices || vertices->size() < 2)
+    {
+        throw InterpreterSemanticError("Error: a polyline or polygon needs at least two points");
+    }
+    head.type = closed ? PolygonType : PolylineType;
+    head.value.shared_value = vertices;
+    tail.clear();
+}
+
+//group expression
+Expression::Expression(const std::shared_ptr<const Group> & group, const Transform & transform)
+{
+    head.type = GroupType;
+    head.value.shared_value = std::make_shared<const Instance>(Instance{group, transform});
+    tail.clear();
+}
+
 //point expression
 Expression::Expression(std::tuple<double,double> value)
 {
@@ -115,6 +145,37 @@ bool Expression::operator==(const Expression & exp) const noexcept
                 flag = false;
             }
         }
+        else if (head.type == ListType)
+        {
+            if (head.list() != exp.head.list())
+            {
+                flag = false;
+            }
+        }
+        else if (head.type == PolylineType || head.type == PolygonType)
+        {
+            if (head.points() != exp.head.points())
+            {
+                flag = false;
+            }
+        }
+        else if (head.type == GroupType)
+        {
+            const Transform & t = head.instance().transform;
+            const Transform & u = exp.head.instance().transform;
+            if (head.instance().group != exp.head.instance().group || t.a != u.a || t.b != u.b
+                || t.c != u.c || t.d != u.d || t.e != u.e || t.f != u.f)
+            {
+                flag = false;
+            }
+        }
+        else if (head.type == LambdaType)
+        {
+            if (head.value.shared_value != exp.head.value.shared_value)
+            {
+                flag = false;
+            }
+        }
     }
     if (tail.size() != exp.tail.size())
     {
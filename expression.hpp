@@ -7,10 +7,13 @@
 #include <tuple>
 #include <cmath>
 #include <limits>
+#include <memory>
+#include <cassert>
 
 // A Type is a literal boolean, literal number, or symbol
 enum Type {NoneType, BooleanType, NumberType, ListType, SymbolType,
-	   PointType, LineType, ArcType};
+	   PointType, LineType, ArcType, PolylineType, PolygonType, GroupType,
+	   LambdaType};
 
 // A Boolean is a C++ bool
 typedef bool Boolean;
@@ -52,6 +55,36 @@ struct Arc
     Number span;
 };
   
+// A PointList is the vertices of a polyline or polygon, at least two of
+// them, kept out of line so an outline is one atom however many vertices
+// it has
+typedef std::vector<Point> PointList;
+
+// A Transform is a 2x3 affine matrix taking x y to a x + c y + e and
+// b x + d y + f, the order QTransform and SVG use
+struct Transform
+{
+    Number a;
+    Number b;
+    Number c;
+    Number d;
+    Number e;
+    Number f;
+};
+
+// A Group is a shape made of atoms, see below
+struct Group;
+
+// An Instance is a shape drawn through a transform, see below
+struct Instance;
+
+// A NumberList is the packed data of a list, lists share it and never
+// change it once made
+typedef std::vector<Number> NumberList;
+
+// A Lambda is a procedure made by the program, see environment.hpp
+struct Lambda;
+
 // A Value is a boolean, number, or symbol
 // cannot use a union because symbol is non-POD
 // this wastes space but is simple 
@@ -63,6 +96,11 @@ struct Value
     Point point_value;
     Line line_value;
     Arc arc_value;
+
+    // the out of line part of a list, outline, group or lambda, whichever
+    // the atom's type says it is. one pointer for all of them keeps every
+    // atom small, read it through the atom's functions below
+    std::shared_ptr<const void> shared_value;
 };
   
 // An Atom has a type and value
@@ -70,6 +108,51 @@ struct Atom
 {
     Type type;
     Value value;
+
+    // the shared value of a list, outline, group or lambda atom. asking
+    // an atom of another type is a bug and fails the assertion
+    const NumberList & list() const
+    {
+        assert(type == ListType);
+        return *static_cast<const NumberList *>(value.shared_value.get());
+    }
+    const PointList & points() const
+    {
+        assert(type == PolylineType || type == PolygonType);
+        return *static_cast<const PointList *>(value.shared_value.get());
+    }
+    const Instance & instance() const
+    {
+        assert(type == GroupType);
+        return *static_cast<const Instance *>(value.shared_value.get());
+    }
+    const Lambda & lambda() const
+    {
+        assert(type == LambdaType);
+        return *static_cast<const Lambda *>(value.shared_value.get());
+    }
+};
+
+// A Group is the atoms of a shape, made once and never changed. A Group
+// atom draws them through the transform of its Instance, so every
+// instance of a shape is a matrix and a reference to the one copy of its
+// atoms. The box around the children is kept with them (see
+// scene_graph.hpp)
+struct Group
+{
+    std::vector<Atom> children;
+    Number left;
+    Number top;
+    Number right;
+    Number bottom;
+};
+
+// An Instance is what a Group atom points to, a shape and where it goes.
+// Copies of the atom share it, the way lists share their numbers
+struct Instance
+{
+    std::shared_ptr<const Group> group;
+    Transform transform;
 };
 
 // An expression is an atom called the head
@@ -90,6 +173,18 @@ struct Expression
   Expression(double num);
   Expression(const std::string & sym);
 
+  // Construct an Expression with a single List atom holding values
+  Expression(const std::shared_ptr<const NumberList> & values);
+
+  // Construct an Expression with a single Polyline atom through vertices,
+  // or a Polygon atom if closed. Throws InterpreterSemanticError if there
+  // are fewer than two vertices
+  Expression(const std::shared_ptr<const PointList> & vertices, bool closed);
+
+  // Construct an Expression with a single Group atom drawing group
+  // through transform
+  Expression(const std::shared_ptr<const Group> & group, const Transform & transform);
+
   // Construct an Expression with a single Point atom with value
   Expression(std::tuple<double,double> value);
   
@@ -0,0 +1,110 @@
+#include "file_watcher.hpp"
+#include "interpreter.hpp"
+
+#include <fstream>
+#include <exception>
+
+#include <QFileInfo>
+
+ScriptEvaluator::ScriptEvaluator()
+{
+    cancelled = false;
+}
+
+void ScriptEvaluator::cancel()
+{
+    cancelled = true;
+}
+
+void ScriptEvaluator::evaluate(QString file)
+{
+    std::ifstream ifs(file.toStdString());
+    if (!ifs.good())
+    {
+        emit failed("Error: Filename could not be found");
+        return;
+    }
+    Interpreter interp;
+    interp.setCancelFlag(&cancelled);
+    if (!interp.parse(ifs))
+    {
+        emit failed("Error: Cannot Parse");
+        return;
+    }
+    try
+    {
+        interp.eval();
+    }
+    catch (const std::exception & ex)
+    {
+        emit failed(QString::fromStdString(ex.what()));
+        return;
+    }
+    interp.setGraphics();
+    emit evaluated(file, interp.getGraphics());
+}
+
+FileWatcher::FileWatcher(QString file, QObject * parent): QObject(parent),
+    file(QFileInfo(file).absoluteFilePath()), evaluator(new ScriptEvaluator), busy(false), pending(false)
+{
+    qRegisterMetaType<DisplayList>("DisplayList");
+
+    debounce.setSingleShot(true);
+    debounce.setInterval(DEBOUNCE_MS);
+    connect(&debounce, &QTimer::timeout, this, &FileWatcher::reload);
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &FileWatcher::fileChanged);
+    watcher.addPath(this->file);
+
+    //results come back to this thread through queued connections
+    evaluator->moveToThread(&worker);
+    connect(this, &FileWatcher::evaluate, evaluator, &ScriptEvaluator::evaluate);
+    connect(evaluator, &ScriptEvaluator::evaluated, this, &FileWatcher::evaluated);
+    connect(evaluator, &ScriptEvaluator::failed, this, &FileWatcher::failed);
+    connect(evaluator, &ScriptEvaluator::evaluated, this, &FileWatcher::finished);
+    connect(evaluator, &ScriptEvaluator::failed, this, &FileWatcher::finished);
+    worker.setStackSize(Interpreter::STACK_SIZE);
+    worker.start();
+
+    reload();
+}
+
+FileWatcher::~FileWatcher()
+{
+    //a long script would otherwise keep the wait going until it is done
+    evaluator->cancel();
+    worker.quit();
+    worker.wait();
+    delete evaluator;
+}
+
+void FileWatcher::reload()
+{
+    //editors that save by replacing the file make the watcher drop it
+    if (!watcher.files().contains(file) && QFileInfo::exists(file))
+    {
+        watcher.addPath(file);
+    }
+    if (busy)
+    {
+        pending = true;
+        return;
+    }
+    busy = true;
+    emit evaluate(file);
+}
+
+//restarting the timer on every write waits for the burst to end
+void FileWatcher::fileChanged()
+{
+    debounce.start();
+}
+
+void FileWatcher::finished()
+{
+    busy = false;
+    if (pending)
+    {
+        pending = false;
+        reload();
+    }
+}
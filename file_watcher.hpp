@@ -0,0 +1,92 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QMetaType>
+
+#include <atomic>
+
+#include "display_list.hpp"
+
+Q_DECLARE_METATYPE(DisplayList)
+
+// ScriptEvaluator runs a script in a fresh Interpreter, on the thread
+// it lives on, and reports what the script drew
+class ScriptEvaluator: public QObject
+{
+  Q_OBJECT
+
+public:
+
+  ScriptEvaluator();
+
+  // stop the evaluation that is running and fail any that are still to
+  // come, safe to call from any thread
+  void cancel();
+
+public slots:
+
+  void evaluate(QString file);
+
+signals:
+
+  void evaluated(QString file, DisplayList graphics);
+
+  void failed(QString message);
+
+private:
+
+  std::atomic<bool> cancelled;
+};
+
+// FileWatcher evaluates a script again whenever it is saved. Bursts of
+// writes are collapsed into one evaluation, which runs on a worker thread
+// so the GUI never waits for it. While an evaluation runs, further saves
+// are collapsed into a single evaluation that follows it.
+class FileWatcher: public QObject
+{
+  Q_OBJECT
+
+public:
+
+  // wait this long after the last write before evaluating
+  static const int DEBOUNCE_MS = 20;
+
+  // watch file and evaluate it once right away
+  FileWatcher(QString file, QObject * parent = nullptr);
+  ~FileWatcher();
+
+public slots:
+
+  // evaluate the file now, or after the evaluation that is running
+  void reload();
+
+signals:
+
+  void evaluated(QString file, DisplayList graphics);
+
+  void failed(QString message);
+
+  void evaluate(QString file);
+
+private slots:
+
+  void fileChanged();
+  void finished();
+
+private:
+
+  QString file;
+  QFileSystemWatcher watcher;
+  QTimer debounce;
+  QThread worker;
+  ScriptEvaluator * evaluator;
+  bool busy;
+  bool pending;
+};
+
+#endif
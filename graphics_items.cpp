@@ -0,0 +1,111 @@
+#include "graphics_items.hpp"
+#include "qgraphics_arc_item.hpp"
+#include "qgraphics_instance_item.hpp"
+#include "sld_format.hpp"
+
+#include <QFile>
+#include <QBrush>
+#include <QLineF>
+#include <QtMath>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsLineItem>
+#include <QGraphicsPathItem>
+#include <QPainterPath>
+
+QGraphicsItem * makeGraphicsItem(const Atom & atom)
+{
+	if (atom.type == PointType)
+	{
+		QGraphicsEllipseItem * point = new QGraphicsEllipseItem(atom.value.point_value.x,
+			atom.value.point_value.y, 2, 2);
+		point->setBrush(QBrush(Qt::black));
+		return point;
+	}
+	else if (atom.type == LineType)
+	{
+		return new QGraphicsLineItem(atom.value.line_value.first.x, atom.value.line_value.first.y,
+			atom.value.line_value.second.x, atom.value.line_value.second.y);
+	}
+	else if (atom.type == ArcType)
+	{
+		double x1, x2, y1, y2;
+		x1 = atom.value.arc_value.center.x;
+		y1 = atom.value.arc_value.center.y;
+		x2 = atom.value.arc_value.start.x;
+		y2 = atom.value.arc_value.start.y;
+		double spanAngle = qRadiansToDegrees((atom.value.arc_value.span) * 16);
+		QLineF line(QLineF(QPointF(x1, y1), QPointF(x2, y2)));
+		double width = line.length() * 2;
+		double height = width;
+		double startAngle = line.angle() * 16;
+		QGraphicsArcItem * arc = new QGraphicsArcItem(x1 - width / 2, y1 - height / 2, width, height);
+		arc->setStartAngle(startAngle);
+		arc->setSpanAngle(spanAngle);
+		return arc;
+	}
+	else if (atom.type == PolylineType || atom.type == PolygonType)
+	{
+		//one item for the whole outline
+		const PointList & vertices = atom.points();
+		QPainterPath path(QPointF(vertices[0].x, vertices[0].y));
+		for (size_t i = 1; i < vertices.size(); i++)
+		{
+			path.lineTo(vertices[i].x, vertices[i].y);
+		}
+		if (atom.type == PolygonType)
+		{
+			path.closeSubpath();
+		}
+		return new QGraphicsPathItem(path);
+	}
+	else if (atom.type == GroupType)
+	{
+		//a matrix and a reference to the shared shape, no copy of it
+		const Instance & instance = atom.instance();
+		return new QGraphicsInstanceItem(instance.group, instance.transform);
+	}
+	return nullptr;
+}
+
+bool loadSld(const QString & file, DisplayList & graphics, std::string & error)
+{
+	QFile sld(file);
+	if (!sld.open(QIODevice::ReadOnly))
+	{
+		error = "Error: Filename could not be found";
+		return false;
+	}
+	const uchar * data = sld.map(0, sld.size());
+	if (!data)
+	{
+		error = "Error: could not map " + file.toStdString();
+		return false;
+	}
+	SldView view;
+	bool ok = view.attach(data, sld.size(), error);
+	if (ok)
+	{
+		graphics = view.displayList();
+	}
+	sld.unmap(const_cast<uchar *>(data));
+	return ok;
+}
+
+bool loadSldItems(const QString & file, const std::function<void(QGraphicsItem *)> & add,
+	std::string & error)
+{
+	DisplayList graphics;
+	if (!loadSld(file, graphics, error))
+	{
+		return false;
+	}
+	for (size_t i = 0; i < graphics.size(); i++)
+	{
+		QGraphicsItem * item = makeGraphicsItem(graphics[i]);
+		if (item)
+		{
+			add(item);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,28 @@
+#ifndef GRAPHICS_ITEMS_HPP
+#define GRAPHICS_ITEMS_HPP
+
+#include <string>
+#include <functional>
+
+#include <QString>
+#include <QGraphicsItem>
+
+#include "expression.hpp"
+#include "display_list.hpp"
+
+// create the QGraphicsItem that draws a point, line, arc, polyline,
+// polygon or group atom
+// returns nullptr for atoms that are not graphics
+QGraphicsItem * makeGraphicsItem(const Atom & atom);
+
+// map a .sld file (see sld_format.hpp) and read its primitives
+// returns false and sets error if the file cannot be read or is not valid
+bool loadSld(const QString & file, DisplayList & graphics, std::string & error);
+
+// map a .sld file and call add with an item for every
+// primitive in it, no program is run
+// returns false and sets error if the file cannot be read or is not valid
+bool loadSldItems(const QString & file, const std::function<void(QGraphicsItem *)> & add,
+	std::string & error);
+
+#endif
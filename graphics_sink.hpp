@@ -0,0 +1,32 @@
+#ifndef GRAPHICS_SINK_HPP
+#define GRAPHICS_SINK_HPP
+
+// system includes
+#include <string>
+
+// module includes
+#include "expression.hpp"
+
+// the layer atoms are drawn on until a program picks another
+const std::string DEFAULT_LAYER = "main";
+
+// A GraphicsSink receives the point, line and arc atoms a program draws
+// as soon as draw produces them, in drawing order. An Environment with a
+// sink hands its graphics over instead of keeping them, so output can be
+// streamed however long the program runs.
+class GraphicsSink
+{
+public:
+  virtual ~GraphicsSink() {}
+  virtual void addGraphic(const Atom & atom) = 0;
+
+  // (layer name) was evaluated, later atoms are drawn on that layer
+  virtual void setLayer(const std::string &) {}
+
+  // (clear) or (clear name) was evaluated, what was drawn on the named
+  // layer, or on every layer if name is empty, is taken back. false if
+  // the sink cannot take back that layer
+  virtual bool clearLayer(const std::string & name) = 0;
+};
+
+#endif
@@ -88,6 +88,34 @@ std::vector<Atom> Interpreter::getGraphics()
 	return graphics;
 }
 
+//forgets everything drawn so far
+void Interpreter::clearGraphics()
+{
+	env.clearGraphics();
+	graphics.clear();
+}
+
+//streams everything drawn from now on to sink, see Environment
+void Interpreter::setGraphicsSink(GraphicsSink * sink)
+{
+	env.setGraphicsSink(sink);
+}
+
+//eval throws an InterpreterSemanticError once flag is set, so another
+//thread can stop a long evaluation
+void Interpreter::setCancelFlag(const std::atomic<bool> * flag)
+{
+	env.setCancelFlag(flag);
+}
+
+//pure builtins called with numbers they were called with before take
+//their value from cache, which the caller owns and can inspect. it is not
+//thread safe, interpreters on different threads need caches of their own
+void Interpreter::setMemoCache(MemoCache * cache)
+{
+	env.setMemoCache(cache);
+}
+
 //this is the validParse private method for the Interpreter class
 //checks to see if the parse has the correct sequence
 bool Interpreter::validParse(TokenSequenceType &tokens)
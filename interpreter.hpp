@@ -18,10 +18,18 @@
 class Interpreter
 {
 public:
+  // the stack a thread evaluating programs needs, a program nesting more
+  // deeply than that allows fails with an error instead
+  static const unsigned STACK_SIZE = 8 * 1024 * 1024;
+
   bool parse(std::istream & expression) noexcept;
   Expression eval();
   void setGraphics();
   std::vector<Atom> getGraphics();
+  void clearGraphics();
+  void setGraphicsSink(GraphicsSink * sink);
+  void setCancelFlag(const std::atomic<bool> * flag);
+  void setMemoCache(MemoCache * cache);
   void reset();
 
 private:
@@ -15,36 +15,17 @@
 #include "canvas_widget.hpp"
 #include "repl_widget.hpp"
 #include "interpreter_semantic_error.hpp"
+#include "file_watcher.hpp"
 
 MainWindow::MainWindow(QWidget * parent): MainWindow("", parent)
 {
-	//create a layout and instantiate all of the Qwidgets
-	QBoxLayout *layout = new QVBoxLayout;
-    QtInterpreter *interpGUI = new QtInterpreter(this);
-    MessageWidget *message = new MessageWidget(this);
-    layout->addWidget(message);
-    CanvasWidget *canvas = new CanvasWidget(this);
-    layout->addWidget(canvas);
-    REPLWidget *repl = new REPLWidget(this);
-    layout->addWidget(repl);
-    this->setLayout(layout);
-    this->setMinimumSize(800, 600);
-
-    //connect all of the signals and slots
-    connect(repl, &REPLWidget::lineEntered, interpGUI, &QtInterpreter::parseAndEvaluate);
-    connect(interpGUI, &QtInterpreter::info, message, &MessageWidget::info);
-    connect(interpGUI, &QtInterpreter::error, message, &MessageWidget::error);
-    connect(interpGUI, &QtInterpreter::drawGraphic, canvas, &CanvasWidget::addGraphic);
-    
-
 }
 
 MainWindow::MainWindow(std::string filename, QWidget * parent): QWidget(parent)
 {
 	//create a layout and instantiate all of the Qwidgets
     QBoxLayout *layout = new QVBoxLayout;
-    QtInterpreter *interpGUI = new QtInterpreter(this);
-    MessageWidget *message = new MessageWidget(this);
+    message = new MessageWidget(this);
     layout->addWidget(message);
     CanvasWidget *canvas = new CanvasWidget(this);
     layout->addWidget(canvas);
@@ -53,13 +34,61 @@ MainWindow::MainWindow(std::string filename, QWidget * parent): QWidget(parent)
     this->setLayout(layout);
     this->setMinimumSize(800, 600);
 
+    //the interpreter gets a thread of its own so a slow script never
+    //freezes the window, everything it sends back is queued
+    interpreterThread = new QThread(this);
+    interpreterThread->setStackSize(Interpreter::STACK_SIZE);
+    interpGUI = new QtInterpreter;
+    interpGUI->moveToThread(interpreterThread);
+    connect(interpreterThread, &QThread::finished, interpGUI, &QObject::deleteLater);
+    interpreterThread->start();
+
     //connect all of the ports
     connect(repl, &REPLWidget::lineEntered, interpGUI, &QtInterpreter::parseAndEvaluate);
+    connect(repl, &REPLWidget::cancelRequested, interpGUI, &QtInterpreter::cancel, Qt::DirectConnection);
+    connect(repl, &REPLWidget::undoRequested, interpGUI, &QtInterpreter::undo);
+    connect(interpGUI, &QtInterpreter::running, repl, &REPLWidget::setRunning);
     connect(interpGUI, &QtInterpreter::info, message, &MessageWidget::info);
     connect(interpGUI, &QtInterpreter::error, message, &MessageWidget::error);
     connect(interpGUI, &QtInterpreter::drawGraphic, canvas, &CanvasWidget::addGraphic);
+    canvas->drainFrom(interpGUI->itemQueue());
+    connect(interpGUI, &QtInterpreter::removeGraphics, canvas, &CanvasWidget::removeGraphics);
+
+    //File->Export saves what has been drawn so far as SVG
+    QMenuBar *menuBar = new QMenuBar(this);
+    QAction *exportAction = menuBar->addMenu("&File")->addAction("&Export...");
+    connect(exportAction, &QAction::triggered, [this]()
+    {
+        QString file = QFileDialog::getSaveFileName(this, "Export", QString(), "SVG images (*.svg)");
+        if (!file.isEmpty())
+        {
+            QMetaObject::invokeMethod(interpGUI, "exportSvg", Qt::QueuedConnection, Q_ARG(QString, file));
+        }
+    });
+    layout->setMenuBar(menuBar);
 
     //send the filename to parse and evaluate by lineEntered
 	QString program = QString::fromStdString(filename);
 	repl->lineEntered(program);
 }
+
+MainWindow::~MainWindow()
+{
+    //a running evaluation is stopped rather than waited for
+    interpGUI->cancel();
+    interpreterThread->quit();
+    interpreterThread->wait();
+}
+
+void MainWindow::setMemoryLimit(qint64 bytes)
+{
+    QMetaObject::invokeMethod(interpGUI, "setMemoryLimit", Qt::QueuedConnection, Q_ARG(qint64, bytes));
+}
+
+void MainWindow::watch(std::string filename)
+{
+    //evaluation happens on the watcher's thread, the canvas only gets the changes
+    FileWatcher *watcher = new FileWatcher(QString::fromStdString(filename), this);
+    connect(watcher, &FileWatcher::evaluated, interpGUI, &QtInterpreter::showDrawing);
+    connect(watcher, &FileWatcher::failed, message, &MessageWidget::error);
+}
@@ -8,6 +8,7 @@
 #include <QDebug>
 
 #include "qt_interpreter.hpp"
+#include "message_widget.hpp"
 
 class MainWindow: public QWidget
 {
@@ -17,9 +18,19 @@ public:
 
   MainWindow(QWidget * parent = nullptr);
   MainWindow(std::string filename, QWidget * parent = nullptr);
+  ~MainWindow();
+
+  // show filename and update the canvas every time it is saved
+  void watch(std::string filename);
+
+  // cap the memory the drawing and its undo history use, see QtInterpreter
+  void setMemoryLimit(qint64 bytes);
 
 private:
   QtInterpreter interp;
+  QtInterpreter * interpGUI;
+  QThread * interpreterThread;
+  MessageWidget * message;
 
   QLineEdit * slispBox;
 };
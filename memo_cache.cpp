@@ -0,0 +1,91 @@
+// module includes
+#include "memo_cache.hpp"
+
+// system includes
+#include <cstring>
+
+static uint64_t bitsOf(double x)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+MemoCache::MemoCache(size_t entries)
+{
+    size_t size = 2;
+    shift = 63;
+    while (size < entries)
+    {
+        size *= 2;
+        shift--;
+    }
+    mask = size - 1;
+    //room to move the table up to the next cache line
+    storage.resize(size * sizeof(Entry) + CACHE_LINE);
+    uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+    address = (address + CACHE_LINE - 1) & ~uintptr_t(CACHE_LINE - 1);
+    table = reinterpret_cast<Entry *>(address);
+    clear();
+}
+
+size_t MemoCache::capacity() const
+{
+    return mask + 1;
+}
+
+//mixes the key and takes the top bits of the product, which depend on all
+//of the key. round numbers have nothing but zeros in their low bits
+size_t MemoCache::slot(unsigned builtin, uint64_t first, uint64_t second) const
+{
+    uint64_t h = first ^ ((second << 32) | (second >> 32)) * 0xC2B2AE3D27D4EB4FULL;
+    h = (h ^ (h >> 32) ^ builtin) * 0x9E3779B97F4A7C15ULL;
+    return size_t(h >> shift);
+}
+
+bool MemoCache::find(unsigned builtin, const double * args, size_t count, double & value)
+{
+    uint64_t first = bitsOf(args[0]);
+    uint64_t second = count > 1 ? bitsOf(args[1]) : 0;
+    const Entry & entry = table[slot(builtin, first, second)];
+    if (builtin != 0 && entry.builtin == builtin && entry.first == first && entry.second == second)
+    {
+        hitCount++;
+        value = entry.value;
+        return true;
+    }
+    missCount++;
+    return false;
+}
+
+void MemoCache::insert(unsigned builtin, const double * args, size_t count, double value)
+{
+    if (builtin == 0)
+    {
+        return;
+    }
+    uint64_t first = bitsOf(args[0]);
+    uint64_t second = count > 1 ? bitsOf(args[1]) : 0;
+    Entry & entry = table[slot(builtin, first, second)];
+    entry.first = first;
+    entry.second = second;
+    entry.value = value;
+    entry.builtin = builtin;
+}
+
+uint64_t MemoCache::hits() const
+{
+    return hitCount;
+}
+
+uint64_t MemoCache::misses() const
+{
+    return missCount;
+}
+
+void MemoCache::clear()
+{
+    std::memset(table, 0, capacity() * sizeof(Entry));
+    hitCount = 0;
+    missCount = 0;
+}
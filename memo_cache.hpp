@@ -0,0 +1,78 @@
+#ifndef MEMO_CACHE_HPP
+#define MEMO_CACHE_HPP
+
+// system includes
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// A MemoCache remembers the values of pure builtins, the ones whose value
+// only depends on the numbers they are called with. An entry is keyed on
+// a builtin id and the exact bits of up to two arguments, so 0 and -0 or
+// two different NaNs never share an entry and a hit is always the value
+// the builtin would have given.
+//
+// The table is direct-mapped and never grows: every key has one slot and
+// a new value simply replaces what was in it. Slots are 32 bytes and the
+// table starts on a cache line, so a lookup touches a single line.
+//
+// Nothing is locked and the counters are plain integers, so a cache must
+// only be used from one thread at a time.
+class MemoCache
+{
+public:
+
+  // a cache of at least entries slots, rounded up to a power of two and
+  // at least two
+  explicit MemoCache(size_t entries = DEFAULT_ENTRIES);
+
+  // the table points into storage, a copy would go on using the storage
+  // of the cache it was copied from
+  MemoCache(const MemoCache &) = delete;
+  MemoCache & operator=(const MemoCache &) = delete;
+
+  // the number of slots
+  size_t capacity() const;
+
+  // the remembered value of builtin for the arguments, count is 1 or 2.
+  // builtin 0 is never remembered. counts a hit or a miss
+  bool find(unsigned builtin, const double * args, size_t count, double & value);
+
+  // remember value for builtin and the arguments, replacing whatever was
+  // in their slot
+  void insert(unsigned builtin, const double * args, size_t count, double value);
+
+  // how many finds were answered from the table and how many were not
+  uint64_t hits() const;
+  uint64_t misses() const;
+
+  // forget every value and reset the counters
+  void clear();
+
+  static const size_t DEFAULT_ENTRIES = 4096;
+
+private:
+
+  static const size_t CACHE_LINE = 64;
+
+  //a builtin of 0 marks an empty slot
+  struct Entry
+  {
+    uint64_t first;
+    uint64_t second;
+    double value;
+    uint32_t builtin;
+    uint32_t pad;
+  };
+
+  std::vector<char> storage;
+  Entry * table;
+  size_t mask;
+  unsigned shift;
+  uint64_t hitCount;
+  uint64_t missCount;
+
+  size_t slot(unsigned builtin, uint64_t first, uint64_t second) const;
+};
+
+#endif
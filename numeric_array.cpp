@@ -0,0 +1,114 @@
+// module includes
+#include "numeric_array.hpp"
+
+// system includes
+#include <cmath>
+
+//the three shapes of a binary kernel, the scalar is loaded once so the
+//loop only streams the array
+template <typename F>
+static void binary(F f, const double * a, bool aScalar, const double * b, bool bScalar,
+                   double * out, size_t n)
+{
+    if (aScalar && bScalar)
+    {
+        double x = a[0], y = b[0];
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = f(x, y);
+        }
+    }
+    else if (aScalar)
+    {
+        double x = a[0];
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = f(x, b[i]);
+        }
+    }
+    else if (bScalar)
+    {
+        double y = b[0];
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = f(a[i], y);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = f(a[i], b[i]);
+        }
+    }
+}
+
+template <typename F>
+static void unary(F f, const double * a, double * out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = f(a[i]);
+    }
+}
+
+//values this close to zero are taken as zero, so (sin pi) is 0. a pass of
+//its own after the sines, where it is a vector compare and select
+static void snap(double * out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = std::fabs(out[i]) < .001 ? 0. : out[i];
+    }
+}
+
+void arrayBinary(ArrayOp op, const double * a, bool aScalar, const double * b, bool bScalar,
+                 double * out, size_t n)
+{
+    switch (op)
+    {
+    case ArrayAdd:
+        binary([](double x, double y) { return x + y; }, a, aScalar, b, bScalar, out, n);
+        break;
+    case ArraySubtract:
+        binary([](double x, double y) { return x - y; }, a, aScalar, b, bScalar, out, n);
+        break;
+    case ArrayMultiply:
+        binary([](double x, double y) { return x * y; }, a, aScalar, b, bScalar, out, n);
+        break;
+    case ArrayDivide:
+        binary([](double x, double y) { return x / y; }, a, aScalar, b, bScalar, out, n);
+        break;
+    case ArrayPow:
+        binary([](double x, double y) { return std::pow(x, y); }, a, aScalar, b, bScalar, out, n);
+        break;
+    case ArrayArctan:
+        binary([](double x, double y) { return std::atan2(x, y); }, a, aScalar, b, bScalar, out, n);
+        break;
+    }
+}
+
+void arrayUnary(ArrayFunction f, const double * a, double * out, size_t n)
+{
+    switch (f)
+    {
+    case ArrayNegate:
+        unary([](double x) { return -x; }, a, out, n);
+        break;
+    case ArraySin:
+        unary([](double x) { return std::sin(x); }, a, out, n);
+        snap(out, n);
+        break;
+    case ArrayCos:
+        unary([](double x) { return std::cos(x); }, a, out, n);
+        break;
+    }
+}
+
+void arrayRange(double from, double step, double * out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = from + double(i) * step;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef NUMERIC_ARRAY_HPP
+#define NUMERIC_ARRAY_HPP
+
+// system includes
+#include <cstddef>
+
+// Element-wise kernels over packed arrays of doubles, the data behind a
+// list value. Every kernel is a plain loop over contiguous memory with no
+// branches in its body. Either operand of a binary kernel can be a single
+// scalar, it is then used for every element of the other.
+//
+// The arithmetic kernels, negate, range and the snapping of small sines
+// are vectorized by the compiler. sin, cos, pow and arctan call the C
+// library once per element, as the builtins on one number do, so a list
+// gives exactly the values its elements would give on their own; the
+// vector math libraries are a few ulps off from that.
+
+enum ArrayOp {ArrayAdd, ArraySubtract, ArrayMultiply, ArrayDivide, ArrayPow, ArrayArctan};
+
+enum ArrayFunction {ArrayNegate, ArraySin, ArrayCos};
+
+// out[i] = a[i] op b[i] for i in [0, n), a[0] for every a[i] if aScalar,
+// and likewise for b. arctan is atan2(a, b) like the arctan builtin
+void arrayBinary(ArrayOp op, const double * a, bool aScalar, const double * b, bool bScalar,
+                 double * out, size_t n);
+
+// out[i] = f(a[i]) for i in [0, n). a sine below 0.001 in magnitude is
+// taken as 0 like the sin builtin does
+void arrayUnary(ArrayFunction f, const double * a, double * out, size_t n);
+
+// out[i] = from + i * step for i in [0, n)
+void arrayRange(double from, double step, double * out, size_t n);
+
+#endif
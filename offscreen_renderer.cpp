@@ -0,0 +1,90 @@
+#include "offscreen_renderer.hpp"
+#include "graphics_items.hpp"
+#include "interpreter.hpp"
+
+#include <fstream>
+#include <exception>
+
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QString>
+
+// blank border around the drawing, in pixels
+static const qreal MARGIN = 10;
+
+// evaluate the script in file and add what it draws to scene
+static bool drawScript(const std::string & file, QGraphicsScene & scene, std::string & error)
+{
+    std::ifstream ifs(file);
+    if (!ifs.good())
+    {
+        error = "Error: Filename could not be found";
+        return false;
+    }
+    Interpreter interp;
+    if (!interp.parse(ifs))
+    {
+        error = "Error: Cannot Parse";
+        return false;
+    }
+    try
+    {
+        interp.eval();
+    }
+    catch (const std::exception & ex)
+    {
+        error = ex.what();
+        return false;
+    }
+    interp.setGraphics();
+    std::vector<Atom> graphics = interp.getGraphics();
+
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        QGraphicsItem * item = makeGraphicsItem(graphics[i]);
+        if (item)
+        {
+            scene.addItem(item);
+        }
+    }
+    return true;
+}
+
+bool renderScript(const std::string & file, QSize size, QImage & image, std::string & error)
+{
+    //the scene owns and deletes the items
+    QGraphicsScene scene;
+    bool sld = file.size() > 4 && file.substr(file.size() - 4) == ".sld";
+    if (sld && !loadSldItems(QString::fromStdString(file), [&scene](QGraphicsItem * item) { scene.addItem(item); }, error))
+    {
+        return false;
+    }
+    if (!sld && !drawScript(file, scene, error))
+    {
+        return false;
+    }
+
+    image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QRectF target = QRectF(QPointF(0, 0), QSizeF(size)).adjusted(MARGIN, MARGIN, -MARGIN, -MARGIN);
+    scene.render(&painter, target, scene.itemsBoundingRect(), Qt::KeepAspectRatio);
+    painter.end();
+    return true;
+}
+
+bool renderScriptToFile(const std::string & file, const std::string & out, QSize size, std::string & error)
+{
+    QImage image;
+    if (!renderScript(file, size, image, error))
+    {
+        return false;
+    }
+    if (!image.save(QString::fromStdString(out)))
+    {
+        error = "Error: could not write image " + out;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,20 @@
+#ifndef OFFSCREEN_RENDERER_HPP
+#define OFFSCREEN_RENDERER_HPP
+
+#include <string>
+
+#include <QImage>
+#include <QSize>
+
+// evaluate the script in file and rasterize everything it draws into an
+// image of the given size, fitted to the drawing with its aspect ratio kept
+// no widgets are created, so this runs on the offscreen platform
+// a .sld file is drawn as it is, without running anything
+// returns false and sets error if the script cannot be read, parsed or evaluated
+bool renderScript(const std::string & file, QSize size, QImage & image, std::string & error);
+
+// render the script in file and save it as an image, the format follows
+// the extension of out (e.g. png)
+bool renderScriptToFile(const std::string & file, const std::string & out, QSize size, std::string & error);
+
+#endif
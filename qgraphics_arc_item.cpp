@@ -4,14 +4,189 @@
 
 #include <QDebug>
 #include <QPainter>
+#include <QPainterPathStroker>
+#include <QtMath>
 #include <QGraphicsEllipseItem>
 #include <QStyleOptionGraphicsItem>
 
-QGraphicsArcItem::QGraphicsArcItem(qreal x, qreal y, qreal width, qreal height, QGraphicsItem *parent) 
+// maximum flattening error of a tessellated arc, in device pixels
+static const qreal ARC_TOLERANCE = 0.25;
+
+// number of zoom buckets per doubling of the scale factor
+static const int BUCKETS_PER_OCTAVE = 2;
+
+// how many zoom buckets each arc keeps a tessellation for
+static const int CACHED_BUCKETS = 4;
+
+// upper limit on the segments of a single arc
+static const int MAX_SEGMENTS = 1024;
+
+QGraphicsArcItem::QGraphicsArcItem(qreal x, qreal y, qreal width, qreal height, QGraphicsItem *parent):
+    QGraphicsEllipseItem(x, y, width, height, parent)
 {
+    tessellations.setMaxCost(CACHED_BUCKETS);
+    tessellatedStart = 0;
+    tessellatedSpan = 0;
+    outlinedStart = 0;
+    outlinedSpan = 0;
+    outlinedWidth = 0;
+    outlineValid = false;
+    //the exposed rect is needed to skip arcs outside of the repainted area
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+//the pen is never thinner than a unit, a cosmetic pen still covers a pixel
+qreal QGraphicsArcItem::strokeWidth() const
+{
+    return qMax(pen().widthF(), qreal(1));
+}
+
+//the point of the ellipse at an angle in degrees, counter clockwise on screen
+QPointF QGraphicsArcItem::arcPoint(qreal degrees) const
+{
+    qreal angle = qDegreesToRadians(degrees);
+    return QPointF(rect().center().x() + rect().width() / 2 * std::cos(angle),
+                   rect().center().y() - rect().height() / 2 * std::sin(angle));
+}
+
+//recomputes the bounds when the geometry changed since they were made,
+//the shape is only stroked again once it is asked for
+void QGraphicsArcItem::updateOutline() const
+{
+    if (rect() == outlinedRect && startAngle() == outlinedStart && spanAngle() == outlinedSpan
+        && strokeWidth() == outlinedWidth && !bounds.isNull())
+    {
+        return;
+    }
+    outlinedRect = rect();
+    outlinedStart = startAngle();
+    outlinedSpan = spanAngle();
+    outlinedWidth = strokeWidth();
+    outlineValid = false;
+
+    //the ends of the arc and every axis crossing in between
+    qreal start = startAngle() / 16.0;
+    qreal span = spanAngle() / 16.0;
+    QRectF box;
+    if (qAbs(span) >= 360)
+    {
+        box = rect();
+    }
+    else
+    {
+        qreal low = qMin(start, start + span);
+        qreal high = qMax(start, start + span);
+        QPointF first = arcPoint(start);
+        QPointF last = arcPoint(start + span);
+        qreal left = qMin(first.x(), last.x()), right = qMax(first.x(), last.x());
+        qreal top = qMin(first.y(), last.y()), bottom = qMax(first.y(), last.y());
+        for (qreal axis = qCeil(low / 90) * 90; axis <= high; axis += 90)
+        {
+            QPointF extreme = arcPoint(axis);
+            left = qMin(left, extreme.x());
+            right = qMax(right, extreme.x());
+            top = qMin(top, extreme.y());
+            bottom = qMax(bottom, extreme.y());
+        }
+        box = QRectF(QPointF(left, top), QPointF(right, bottom));
+    }
+    qreal half = outlinedWidth / 2;
+    bounds = box.adjusted(-half, -half, half, half);
+}
+
+QRectF QGraphicsArcItem::boundingRect() const
+{
+    updateOutline();
+    return bounds;
+}
+
+QPainterPath QGraphicsArcItem::shape() const
+{
+    updateOutline();
+    if (!outlineValid)
+    {
+        QPainterPath path;
+        path.arcMoveTo(rect(), startAngle() / 16.0);
+        path.arcTo(rect(), startAngle() / 16.0, spanAngle() / 16.0);
+        QPainterPathStroker stroker;
+        stroker.setWidth(outlinedWidth);
+        outline = stroker.createStroke(path);
+        outlineValid = true;
+    }
+    return outline;
 }
 
 void QGraphicsArcItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
-  	painter->drawArc(this->rect(), this->startAngle(), this->spanAngle());
+    //nothing of the arc is inside the area being repainted
+    if (!option->exposedRect.isEmpty() && !option->exposedRect.intersects(boundingRect()))
+    {
+        return;
+    }
+
+    //the arc covers less than a pixel, draw it as a single dot in its
+    //middle, the center of the ellipse may be outside the bounds
+    qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+    if (rect().width() * lod < 1 && rect().height() * lod < 1)
+    {
+        QPen dot = pen();
+        dot.setCosmetic(true);
+        painter->setPen(dot);
+        painter->drawPoint(arcPoint((startAngle() + spanAngle() / 2.0) / 16.0));
+        return;
+    }
+    painter->setPen(pen());
+    painter->drawPolyline(tessellation(zoomBucket(lod)));
+}
+
+//maps a scale factor to its zoom bucket, half an octave wide
+int QGraphicsArcItem::zoomBucket(qreal lod) const
+{
+    return qFloor(std::log2(lod) * BUCKETS_PER_OCTAVE);
+}
+
+//flattens the arc into a polyline that is within the tolerance at the
+//largest scale of the bucket, so at every scale in it, reusing the cached
+//one when there is one
+const QPolygonF & QGraphicsArcItem::tessellation(int bucket)
+{
+    if (rect() != tessellatedRect || startAngle() != tessellatedStart || spanAngle() != tessellatedSpan)
+    {
+        tessellations.clear();
+        tessellatedRect = rect();
+        tessellatedStart = startAngle();
+        tessellatedSpan = spanAngle();
+    }
+    QPolygonF * cached = tessellations.object(bucket);
+    if (cached)
+    {
+        return *cached;
+    }
+
+    //tolerance in item coordinates at the top of the bucket, and the angle
+    //step that stays within it
+    qreal lod = std::pow(2.0, (bucket + 1.0) / BUCKETS_PER_OCTAVE);
+    qreal radius = qMax(rect().width(), rect().height()) / 2;
+    qreal tolerance = qMin(ARC_TOLERANCE / lod, radius);
+    qreal step = 2 * std::acos(1 - tolerance / radius);
+    qreal start = qDegreesToRadians(startAngle() / 16.0);
+    qreal span = qDegreesToRadians(spanAngle() / 16.0);
+    int segments = 1;
+    if (step > 0)
+    {
+        segments = qBound(1, qCeil(qAbs(span) / step), MAX_SEGMENTS);
+    }
+
+    //angles grow counter clockwise on screen, so y is flipped
+    QPolygonF * polygon = new QPolygonF(segments + 1);
+    QPointF center = rect().center();
+    qreal rx = rect().width() / 2;
+    qreal ry = rect().height() / 2;
+    for (int i = 0; i <= segments; i++)
+    {
+        qreal angle = start + span * i / segments;
+        (*polygon)[i] = QPointF(center.x() + rx * std::cos(angle), center.y() - ry * std::sin(angle));
+    }
+    tessellations.insert(bucket, polygon);
+    return *polygon;
 }
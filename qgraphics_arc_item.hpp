@@ -2,6 +2,9 @@
 #define QGRAPHIC_ARC_ITEM_HPP
 
 #include <QGraphicsEllipseItem>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <QCache>
 
 class QGraphicsArcItem: public QGraphicsEllipseItem
 {
@@ -11,9 +14,44 @@ public:
   QGraphicsArcItem(qreal x, qreal y, qreal width, qreal height,
 		   QGraphicsItem *parent = nullptr);
 
+  // the box around the swept arc and its stroke, not the whole ellipse
+  QRectF boundingRect() const;
+
+  // the stroked arc, so only the curve itself can be hit
+  QPainterPath shape() const;
+
   void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
 
+  // the zoom bucket a scale factor falls in
+  int zoomBucket(qreal lod) const;
+
+  // the arc flattened for a zoom bucket, it is within a quarter pixel of
+  // the curve at every scale of the bucket
+  const QPolygonF & tessellation(int bucket);
+
 private:
+
+  // the geometry the bounds and shape were last made for, the ellipse
+  // item's setters are not virtual so it is checked on every use
+  mutable QRectF outlinedRect;
+  mutable int outlinedStart;
+  mutable int outlinedSpan;
+  mutable qreal outlinedWidth;
+  mutable QRectF bounds;
+  mutable QPainterPath outline;
+  mutable bool outlineValid;
+
+  qreal strokeWidth() const;
+  void updateOutline() const;
+  QPointF arcPoint(qreal degrees) const;
+
+  // flattened arcs keyed by zoom bucket, only a few buckets are kept
+  QCache<int, QPolygonF> tessellations;
+
+  // the arc geometry the cached tessellations were made for
+  QRectF tessellatedRect;
+  int tessellatedStart;
+  int tessellatedSpan;
 };
 
 
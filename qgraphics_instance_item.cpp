@@ -0,0 +1,144 @@
+#include "qgraphics_instance_item.hpp"
+
+#include <cmath>
+
+#include <QPen>
+#include <QBrush>
+#include <QLineF>
+#include <QPainter>
+#include <QPolygonF>
+#include <QTransform>
+#include <QtMath>
+#include <QStyleOptionGraphicsItem>
+
+#include "scene_graph.hpp"
+
+// room around the shape in scene units, points reach two units to the
+// right of and below where they are and the pen half a unit further
+static const qreal STROKE_PAD = 3;
+
+// how near a stroke a point has to be to hit it in the scene, half the pen
+static const qreal HIT_TOLERANCE = 0.5;
+
+static QTransform toQTransform(const Transform & transform)
+{
+    return QTransform(transform.a, transform.b, transform.c, transform.d, transform.e, transform.f);
+}
+
+QGraphicsInstanceItem::QGraphicsInstanceItem(const std::shared_ptr<const Group> & group,
+    const Transform & transform, QGraphicsItem *parent): QGraphicsItem(parent), group(group)
+{
+    //the pad is in the scene, where the strokes are drawn
+    Bounds box = transformBounds(transform, groupBounds(*group));
+    bool flat = transform.a * transform.d - transform.b * transform.c == 0;
+    if (!box.empty() && !flat)
+    {
+        QRectF scene = QRectF(box.left, box.top, box.width(), box.height())
+            .adjusted(-STROKE_PAD, -STROKE_PAD, STROKE_PAD, STROKE_PAD);
+        bounds = toQTransform(invertTransform(transform)).mapRect(scene);
+    }
+    setTransform(toQTransform(transform));
+    //the exposed rect is needed to skip instances outside of the repainted area
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+QRectF QGraphicsInstanceItem::boundingRect() const
+{
+    return bounds;
+}
+
+//only the strokes are hit, and only the groups whose box holds the point
+//are looked into. the tolerance is shrunk to the shape's own units
+bool QGraphicsInstanceItem::contains(const QPointF & point) const
+{
+    Point local = {point.x(), point.y()};
+    qreal scale = std::sqrt(std::fabs(transform().determinant()));
+    return scale > 0 && hitGroup(*group, local, HIT_TOLERANCE / scale);
+}
+
+void QGraphicsInstanceItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    if (!option->exposedRect.isEmpty() && !option->exposedRect.intersects(bounds))
+    {
+        return;
+    }
+    //paint in scene coordinates, the pen would be scaled with the item
+    QTransform toScene = sceneTransform();
+    Transform instance = {toScene.m11(), toScene.m12(), toScene.m21(), toScene.m22(), toScene.dx(), toScene.dy()};
+    painter->save();
+    painter->setWorldTransform(toScene.inverted() * painter->worldTransform());
+    painter->setPen(QPen());
+    paintShape(painter, *group, instance,
+        option->exposedRect.isEmpty() ? QRectF() : toScene.mapRect(option->exposedRect));
+    painter->restore();
+}
+
+//draws the atoms of a shape moved by transform as the other items draw
+//them, a shape inside it is skipped if its box misses the exposed area of
+//the scene
+void QGraphicsInstanceItem::paintShape(QPainter *painter, const Group & group, const Transform & transform,
+    const QRectF & exposed)
+{
+    for (size_t i = 0; i < group.children.size(); i++)
+    {
+        const Atom & child = group.children[i];
+        if (child.type == GroupType)
+        {
+            const Instance & instance = child.instance();
+            Transform inner = composeTransforms(transform, instance.transform);
+            Bounds box = transformBounds(inner, groupBounds(*instance.group));
+            if (box.empty())
+            {
+                continue;
+            }
+            QRectF scene = QRectF(box.left, box.top, box.width(), box.height())
+                .adjusted(-STROKE_PAD, -STROKE_PAD, STROKE_PAD, STROKE_PAD);
+            if (exposed.isEmpty() || exposed.intersects(scene))
+            {
+                paintShape(painter, *instance.group, inner, exposed);
+            }
+            continue;
+        }
+        if (child.type == PolylineType || child.type == PolygonType)
+        {
+            //the vertices are moved straight into the polygon
+            const PointList & vertices = child.points();
+            QPolygonF polygon(int(vertices.size()));
+            for (size_t j = 0; j < vertices.size(); j++)
+            {
+                Point moved = transformPoint(transform, vertices[j]);
+                polygon[int(j)] = QPointF(moved.x, moved.y);
+            }
+            if (child.type == PolygonType)
+            {
+                painter->drawPolygon(polygon);
+            }
+            else
+            {
+                painter->drawPolyline(polygon);
+            }
+            continue;
+        }
+        Atom atom = transformAtom(child, transform);
+        if (atom.type == PointType)
+        {
+            painter->setBrush(QBrush(Qt::black));
+            painter->drawEllipse(QRectF(atom.value.point_value.x, atom.value.point_value.y, 2, 2));
+            painter->setBrush(Qt::NoBrush);
+        }
+        else if (atom.type == LineType)
+        {
+            painter->drawLine(QLineF(atom.value.line_value.first.x, atom.value.line_value.first.y,
+                atom.value.line_value.second.x, atom.value.line_value.second.y));
+        }
+        else if (atom.type == ArcType)
+        {
+            const Arc & arc = atom.value.arc_value;
+            QLineF radius(QPointF(arc.center.x, arc.center.y), QPointF(arc.start.x, arc.start.y));
+            qreal size = radius.length() * 2;
+            painter->drawArc(QRectF(arc.center.x - size / 2, arc.center.y - size / 2, size, size),
+                qRound(radius.angle() * 16), qRound(qRadiansToDegrees(arc.span) * 16));
+        }
+    }
+}
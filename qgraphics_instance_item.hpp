@@ -0,0 +1,44 @@
+#ifndef QGRAPHICS_INSTANCE_ITEM_HPP
+#define QGRAPHICS_INSTANCE_ITEM_HPP
+
+#include <memory>
+
+#include <QGraphicsItem>
+#include <QRectF>
+#include <QPointF>
+
+#include "expression.hpp"
+
+// QGraphicsInstanceItem draws one instance of a shape made with group,
+// translate, rotate or scale. It only refers to the atoms of the shape,
+// which every instance shares. Where the instance goes is the item's
+// transform. The atoms are moved into place as they are drawn and stroked
+// in scene units, so a scaled instance has the same pen and points as
+// everything else, as in the rasterizer.
+class QGraphicsInstanceItem: public QGraphicsItem
+{
+
+public:
+
+  QGraphicsInstanceItem(const std::shared_ptr<const Group> & group, const Transform & transform,
+		   QGraphicsItem *parent = nullptr);
+
+  // the box around the shape and its stroke, before the transform
+  QRectF boundingRect() const;
+
+  // whether a point passes near a stroke of the shape
+  bool contains(const QPointF & point) const;
+
+  void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+
+private:
+
+  std::shared_ptr<const Group> group;
+  QRectF bounds;
+
+  static void paintShape(QPainter *painter, const Group & group, const Transform & transform,
+                         const QRectF & exposed);
+};
+
+
+#endif
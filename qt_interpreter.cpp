@@ -3,7 +3,8 @@
 #include "message_widget.hpp"
 #include "repl_widget.hpp"
 #include "tokenize.hpp"
-#include "qgraphics_arc_item.hpp"
+#include "graphics_items.hpp"
+#include "svg_writer.hpp"
 #include "interpreter_semantic_error.hpp"
 
 //system includes
@@ -12,6 +13,9 @@
 #include <iostream>
 #include <cmath>
 #include <fstream>
+#include <algorithm>
+#include <thread>
+#include <chrono>
 
 //QT includes
 #include <QLineEdit>
@@ -19,26 +23,77 @@
 #include <QBrush>
 #include <QDebug>
 #include <QString>
+#include <QStringList>
 #include <QtMath>
 #include <QGraphicsEllipseItem>
 #include <QGraphicsItem>
 #include <QStyleOptionGraphicsItem>
+#include <QFileInfo>
 
 
-QtInterpreter::QtInterpreter(QObject * parent): QObject(parent)
+//a rough size of an item and its place in the scene index
+static const qint64 ITEM_BYTES = 256;
+
+//the atoms of a display list and the vertices of its outlines
+static qint64 displayListBytes(const DisplayList & graphics)
+{
+	qint64 bytes = graphics.size() * sizeof(Atom);
+	for (size_t i = 0; i < graphics.size(); i++)
+	{
+		if (graphics[i].type == PolylineType || graphics[i].type == PolygonType)
+		{
+			bytes += graphics[i].points().size() * sizeof(Point);
+		}
+	}
+	return bytes;
+}
+
+//room for a long REPL session on a small machine
+static const qint64 DEFAULT_MEMORY_LIMIT = qint64(256) << 20;
+
+QtInterpreter::QtInterpreter(QObject * parent): QObject(parent), queue(QUEUE_CAPACITY)
+{
+	//items are made here and added to the scene on the GUI thread
+	qRegisterMetaType<QGraphicsItem *>("QGraphicsItem*");
+	qRegisterMetaType<QVector<QGraphicsItem *> >("QVector<QGraphicsItem*>");
+	cancelled = false;
+	inter.setCancelFlag(&cancelled);
+	currentLayer = QString::fromStdString(DEFAULT_LAYER);
+	entries = 0;
+	fileEntry = false;
+	collecting = false;
+	memoryLimit = DEFAULT_MEMORY_LIMIT;
+}
+
+void QtInterpreter::cancel()
+{
+	cancelled = true;
+}
+
+SpscQueue<QGraphicsItem *> * QtInterpreter::itemQueue()
 {
+	return &queue;
 }
 
 void QtInterpreter::parseAndEvaluate(QString entry)
 {
   	std::string parse = entry.toStdString();
   	bool validParse = false;
+  	QString file;
   	//check to see if the entry is a file name
   	//if so, parse the file
   	if (parse.empty())
   	{
   		return;
   	}
+  	if (parse.length() > 4 && parse.substr(parse.length() - 4) == ".sld") //evaluated geometry, nothing to run
+  	{
+  		openDrawing(entry);
+  		return;
+  	}
+  	//a cancel meant for an earlier entry does not stop this one
+  	cancelled = false;
+  	emit running(true);
   	if (parse.length() > 4) //check to see if the entry is a file name. if so, parse the file
   	{
   		if (parse.substr(parse.length() - 4, parse.length()) == ".slp")
@@ -47,9 +102,11 @@ void QtInterpreter::parseAndEvaluate(QString entry)
   			if (!ifs.good())
   			{
   				std::cout << "Error: Filename could not be found" << std::endl;
+  				emit running(false);
   				return;
   			}
   			validParse = inter.parse(ifs);
+  			file = QFileInfo(entry).absoluteFilePath();
   		}
   		else //is a normal Query, take from ReplWidget
   		{
@@ -66,40 +123,45 @@ void QtInterpreter::parseAndEvaluate(QString entry)
     Expression exp;
     if (validParse) 
     {
+    	//a file draws on its own layer, everything else on the current one
+    	entries++;
+    	fileEntry = !file.isEmpty();
+    	target = fileEntry ? file : currentLayer;
+    	collecting = fileEntry && layers.find(file) != layers.end();
+    	inter.setGraphicsSink(this);
       	try 
       	{
           	exp = inter.eval();
-          	determineGraphic(exp);
+          	if (collecting)
+          	{
+          		Delta replaced = {Delta::Replaced, file, 0, layers[file].graphics};
+          		pending.push_back(replaced);
+          		replaceLayer(file, collected);
+          	}
+          	commit();
           	output(exp);
       	}
       	catch (const std::exception & ex) 
       	{
+      		//nothing of a failed evaluation is shown
+      		revert(pending);
+      		pending.clear();
+      		inter.clearGraphics();
         	QString errorMessage = QString::fromStdString(ex.what());
         	emit error(errorMessage);
       	}
+      	inter.setGraphicsSink(nullptr);
+      	collecting = false;
+      	collected.clear();
     }
     else 
     {
         QString errorMessage = "Error: Cannot Parse";
         emit error(errorMessage);
     }
+    emit running(false);
 }
 
-void QtInterpreter::determineGraphic(Expression exp)
-{
-	inter.setGraphics();
-	std::vector<Atom> args = inter.getGraphics();
-	if (!args.empty()) //if the ast has draw as its head
-	{
-		drawGraphics(args);
-	}
-	else
-	{
-		output(exp);
-    }
-}
-
-
 void QtInterpreter::output(Expression exp)
 {
 	QString Output;
@@ -153,6 +215,48 @@ void QtInterpreter::output(Expression exp)
 		Output = openP + openP + x1 + "," + y1 + closedP + "," + openP + x2 + "," + y2 + closedP + " " + angle + closedP;
 		emit info(Output);	
 	}
+	else if (exp.head.type == PolylineType || exp.head.type == PolygonType)
+	{
+		//a long outline is cut short
+		const PointList & vertices = exp.head.points();
+		QStringList points;
+		for (size_t i = 0; i < vertices.size() && i < 10; i++)
+		{
+			points << openP + QString::number(vertices[i].x) + "," + QString::number(vertices[i].y) + closedP;
+		}
+		if (vertices.size() > 10)
+		{
+			points << "...";
+		}
+		Output = openP + points.join(",") + closedP;
+		emit info(Output);
+	}
+	else if (exp.head.type == ListType)
+	{
+		//a long list is cut short
+		const NumberList & values = exp.head.list();
+		QStringList numbers;
+		for (size_t i = 0; i < values.size() && i < 10; i++)
+		{
+			numbers << QString::number(values[i]);
+		}
+		if (values.size() > 10)
+		{
+			numbers << "...";
+		}
+		Output = openP + numbers.join(" ") + closedP;
+		emit info(Output);
+	}
+	else if (exp.head.type == GroupType)
+	{
+		Output = "(group)";
+		emit info(Output);
+	}
+	else if (exp.head.type == LambdaType)
+	{
+		Output = "(procedure)";
+		emit info(Output);
+	}
 	else if (exp.head.type == NoneType)
 	{
 		Output = "(None)";
@@ -161,43 +265,350 @@ void QtInterpreter::output(Expression exp)
 }
 
 
-void QtInterpreter::drawGraphics(std::vector<Atom> args)
+//makes the item for an atom as soon as it is drawn and queues it, if the
+//canvas has fallen a whole queue behind this waits for it to catch up
+void QtInterpreter::addGraphic(const Atom & atom)
 {
-	//loop through the vector and draw all of the points/lines/arcs
-	for (int i = 0; i < args.size(); i++) 
+	if (collecting)
 	{
-		if (args[i].type == PointType)
-		{		
-			QGraphicsEllipseItem * point = new QGraphicsEllipseItem(args[i].value.point_value.x, 
-				args[i].value.point_value.y, 2, 2);
-			point->setBrush(QBrush(Qt::black));
-            emit drawGraphic(point);
+		collected.push_back(atom);
+		return;
+	}
+	QGraphicsItem * item = makeGraphicsItem(atom);
+	if (item)
+	{
+		while (!queue.tryPush(item))
+		{
+			if (cancelled)
+			{
+				delete item;
+				throw InterpreterSemanticError("Error: evaluation cancelled");
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
 		}
-		else if (args[i].type == LineType)
-		{		
-			QGraphicsLineItem * line = new QGraphicsLineItem(args[i].value.line_value.first.x, args[i].value.line_value.first.y,
-        		args[i].value.line_value.second.x, args[i].value.line_value.second.y);                                                       
-			emit drawGraphic(line);
+	}
+	addToLayer(target, atom, item);
+}
+
+//a file always draws on its own layer, so it can be diffed when it is
+//entered again
+void QtInterpreter::setLayer(const std::string & name)
+{
+	if (!fileEntry)
+	{
+		currentLayer = QString::fromStdString(name);
+		target = currentLayer;
+	}
+}
+
+bool QtInterpreter::clearLayer(const std::string & name)
+{
+	QVector<QGraphicsItem *> removed;
+	if (name.empty())
+	{
+		std::vector<QString> names;
+		for (auto it = layers.begin(); it != layers.end(); ++it)
+		{
+			names.push_back(it->first);
 		}
-		else if (args[i].type == ArcType)
+		for (size_t i = 0; i < names.size(); i++)
 		{
-			double x1, x2, y1, y2;
-			x1 = args[i].value.arc_value.center.x;
-			y1 = args[i].value.arc_value.center.y;
-			x2 = args[i].value.arc_value.start.x;
-			y2 = args[i].value.arc_value.start.y;
-			double spanAngle = qRadiansToDegrees((args[i].value.arc_value.span) * 16);
-			QLineF line(QLineF(QPointF(x1, y1), QPointF(x2, y2)));
-			double width = line.length() * 2;
-			double height = width;
-			double startAngle = line.angle() * 16;
-			QGraphicsArcItem * arc = new QGraphicsArcItem(x1, y1, width, height);;
-			arc->setRect(QRectF(x1 - width / 2, y1 - height / 2, width, height));
-			arc->setStartAngle(startAngle);
-			arc->setSpanAngle(spanAngle);
-			emit drawGraphic(arc);
-		}	
+			//a shown file being entered again is replaced when it is done
+			if (!collecting || names[i] != target)
+			{
+				takeLayer(names[i], removed);
+			}
+		}
+		collected.clear();
+	}
+	else if (collecting && QString::fromStdString(name) == target)
+	{
+		collected.clear();
+	}
+	else
+	{
+		takeLayer(QString::fromStdString(name), removed);
+	}
+	if (!removed.isEmpty())
+	{
+		emit removeGraphics(removed);
+	}
+	return true;
+}
+
+//puts an atom and its item, which the canvas has or will get, on a layer
+void QtInterpreter::addToLayer(const QString & name, const Atom & atom, QGraphicsItem * item)
+{
+	Layer & layer = layers[name];
+	layer.graphics.push_back(atom);
+	layer.items.push_back(item);
+	layer.used = entries;
+	if (!pending.empty() && pending.back().kind == Delta::Added && pending.back().layer == name)
+	{
+		pending.back().added++;
+	}
+	else
+	{
+		Delta added = {Delta::Added, name, 1, DisplayList()};
+		pending.push_back(added);
 	}
+}
 
+//takes a whole layer off the canvas, remembering its primitives
+void QtInterpreter::takeLayer(const QString & name, QVector<QGraphicsItem *> & removed)
+{
+	auto it = layers.find(name);
+	if (it == layers.end())
+	{
+		return;
+	}
+	for (size_t i = 0; i < it->second.items.size(); i++)
+	{
+		if (it->second.items[i])
+		{
+			removed.push_back(it->second.items[i]);
+		}
+	}
+	Delta cleared = {Delta::Cleared, name, 0, DisplayList()};
+	cleared.before.swap(it->second.graphics);
+	pending.push_back(cleared);
+	layers.erase(it);
 }
 
+//undoes deltas, newest first, without recording anything
+void QtInterpreter::revert(const std::vector<Delta> & deltas)
+{
+	QVector<QGraphicsItem *> removed;
+	for (size_t i = deltas.size(); i-- > 0;)
+	{
+		const Delta & delta = deltas[i];
+		if (delta.kind == Delta::Added)
+		{
+			auto it = layers.find(delta.layer);
+			if (it == layers.end())
+			{
+				continue;
+			}
+			Layer & layer = it->second;
+			size_t kept = layer.graphics.size() - std::min(delta.added, layer.graphics.size());
+			for (size_t j = kept; j < layer.items.size(); j++)
+			{
+				if (layer.items[j])
+				{
+					removed.push_back(layer.items[j]);
+				}
+			}
+			layer.graphics.resize(kept);
+			layer.items.resize(kept);
+			if (kept == 0)
+			{
+				layers.erase(it);
+			}
+		}
+		else if (delta.kind == Delta::Cleared)
+		{
+			Layer & layer = layers[delta.layer];
+			for (size_t j = 0; j < delta.before.size(); j++)
+			{
+				QGraphicsItem * item = makeGraphicsItem(delta.before[j]);
+				layer.graphics.push_back(delta.before[j]);
+				layer.items.push_back(item);
+				if (item)
+				{
+					emit drawGraphic(item);
+				}
+			}
+			layer.used = entries;
+		}
+		else
+		{
+			replaceLayer(delta.layer, delta.before);
+		}
+	}
+	if (!removed.isEmpty())
+	{
+		emit removeGraphics(removed);
+	}
+}
+
+//what was done since the last step becomes one undo step
+void QtInterpreter::commit()
+{
+	if (!pending.empty())
+	{
+		history.push_back(std::vector<Delta>());
+		history.back().swap(pending);
+	}
+	enforceLimit();
+}
+
+void QtInterpreter::undo()
+{
+	if (history.empty())
+	{
+		emit error("Error: nothing to undo");
+		return;
+	}
+	entries++;
+	revert(history.back());
+	history.pop_back();
+}
+
+void QtInterpreter::setMemoryLimit(qint64 bytes)
+{
+	memoryLimit = bytes;
+	enforceLimit();
+}
+
+qint64 QtInterpreter::memoryUsage() const
+{
+	qint64 bytes = 0;
+	for (auto it = layers.begin(); it != layers.end(); ++it)
+	{
+		bytes += layerBytes(it->second);
+	}
+	for (size_t i = 0; i < history.size(); i++)
+	{
+		bytes += stepBytes(history[i]);
+	}
+	return bytes;
+}
+
+qint64 QtInterpreter::layerBytes(const Layer & layer)
+{
+	return displayListBytes(layer.graphics) + layer.items.size() * (sizeof(QGraphicsItem *) + ITEM_BYTES);
+}
+
+qint64 QtInterpreter::stepBytes(const std::vector<Delta> & step)
+{
+	qint64 bytes = 0;
+	for (size_t i = 0; i < step.size(); i++)
+	{
+		bytes += sizeof(Delta) + displayListBytes(step[i].before);
+	}
+	return bytes;
+}
+
+//the undo history goes first since none of it is on the canvas, then the
+//layers drawn on longest ago. what the last step drew is always kept
+void QtInterpreter::enforceLimit()
+{
+	qint64 bytes = memoryUsage();
+	while (bytes > memoryLimit && !history.empty())
+	{
+		bytes -= stepBytes(history.front());
+		history.pop_front();
+	}
+	QVector<QGraphicsItem *> removed;
+	while (bytes > memoryLimit)
+	{
+		auto oldest = layers.end();
+		for (auto it = layers.begin(); it != layers.end(); ++it)
+		{
+			if (it->second.used < entries && (oldest == layers.end() || it->second.used < oldest->second.used))
+			{
+				oldest = it;
+			}
+		}
+		if (oldest == layers.end())
+		{
+			break;
+		}
+		for (size_t i = 0; i < oldest->second.items.size(); i++)
+		{
+			if (oldest->second.items[i])
+			{
+				removed.push_back(oldest->second.items[i]);
+			}
+		}
+		bytes -= layerBytes(oldest->second);
+		layers.erase(oldest);
+	}
+	if (!removed.isEmpty())
+	{
+		emit removeGraphics(removed);
+	}
+}
+
+//shows a drawing on a layer, if the layer was shown before only the
+//primitives that changed are removed or added
+void QtInterpreter::replaceLayer(const QString & name, const DisplayList & graphics)
+{
+	Layer & shown = layers[name];
+	DisplayListDiff diff = diffDisplayLists(shown.graphics, graphics);
+	QVector<QGraphicsItem *> removed;
+	for (size_t i = 0; i < diff.removed.size(); i++)
+	{
+		QGraphicsItem * item = shown.items[diff.removed[i]];
+		if (item)
+		{
+			removed.push_back(item);
+		}
+	}
+	if (!removed.isEmpty())
+	{
+		emit removeGraphics(removed);
+	}
+	std::vector<QGraphicsItem *> items(graphics.size(), nullptr);
+	for (size_t i = 0; i < graphics.size(); i++)
+	{
+		if (diff.kept[i] != DIFF_ADDED)
+		{
+			items[i] = shown.items[diff.kept[i]];
+		}
+		else
+		{
+			items[i] = makeGraphicsItem(graphics[i]);
+			if (items[i])
+			{
+				emit drawGraphic(items[i]);
+			}
+		}
+	}
+	shown.graphics = graphics;
+	shown.items = items;
+	shown.used = entries;
+	if (graphics.empty())
+	{
+		layers.erase(name);
+	}
+}
+
+//shows what a file drew as one undo step
+void QtInterpreter::showDrawing(const QString & file, const DisplayList & graphics)
+{
+	entries++;
+	auto it = layers.find(file);
+	Delta replaced = {Delta::Replaced, file, 0, it != layers.end() ? it->second.graphics : DisplayList()};
+	pending.push_back(replaced);
+	replaceLayer(file, graphics);
+	commit();
+}
+
+//writes everything drawn so far to an SVG file
+void QtInterpreter::exportSvg(QString file)
+{
+	DisplayList graphics;
+	for (auto it = layers.begin(); it != layers.end(); ++it)
+	{
+		graphics.insert(graphics.end(), it->second.graphics.begin(), it->second.graphics.end());
+	}
+	if (!writeSvg(file.toStdString(), graphics))
+	{
+		emit error("Error: could not write " + file);
+	}
+}
+
+//draws the primitives of a .sld file without running anything, opening
+//it again only replaces what changed
+void QtInterpreter::openDrawing(QString file)
+{
+	std::string message;
+	DisplayList graphics;
+	if (!loadSld(file, graphics, message))
+	{
+		emit error(QString::fromStdString(message));
+		return;
+	}
+	showDrawing(QFileInfo(file).absoluteFilePath(), graphics);
+}
@@ -1,39 +1,128 @@
 #ifndef QT_INTERPRETER_HPP
 #define QT_INTERPRETER_HPP
 
+#include <map>
+#include <deque>
 #include <string>
+#include <vector>
+#include <atomic>
 
 #include <QObject>
 #include <QString>
+#include <QVector>
 #include <QGraphicsItem>
 
 #include "interpreter.hpp"
+#include "display_list.hpp"
+#include "graphics_sink.hpp"
+#include "spsc_queue.hpp"
 
-class QtInterpreter: public QObject, private Interpreter{
+class QtInterpreter: public QObject, private Interpreter, private GraphicsSink{
 Q_OBJECT
 
 public:
 
   QtInterpreter(QObject * parent = nullptr);
 
+  // stop the evaluation that is running, safe to call from any thread
+  // the evaluation ends with an error and draws nothing
+  void cancel();
+
+  // the items of the entry being evaluated, in drawing order, for the GUI
+  // thread to take and add to the scene. when the queue is full the
+  // evaluation waits for it to be drained, until it is cancelled
+  SpscQueue<QGraphicsItem *> * itemQueue();
+
+  // roughly how much memory the drawing and its undo history use, in bytes
+  qint64 memoryUsage() const;
+
 signals:
 
   void drawGraphic(QGraphicsItem * item);
 
+  // items that are taken off the canvas, the canvas deletes them
+  void removeGraphics(QVector<QGraphicsItem *> items);
+
   void info(QString message);
 
   void error(QString message);
 
+  // true when an entry starts being evaluated, false when it is done
+  void running(bool busy);
+
 public slots:
 
   void parseAndEvaluate(QString entry);
   void output(Expression exp);
+  void exportSvg(QString file);
+  void openDrawing(QString file);
+  void showDrawing(const QString & file, const DisplayList & graphics);
+
+  // take back what the last entry, opened drawing or reload changed
+  void undo();
+
+  // once the drawing and its history use more than bytes, the oldest undo
+  // steps are dropped and then the layers drawn on longest ago
+  void setMemoryLimit(qint64 bytes);
 
  private:
  	Interpreter inter;
  	QString toString(QString input);
- 	void determineGraphic(Expression exp);
- 	void drawGraphics(std::vector<Atom> args);
+
+ 	std::atomic<bool> cancelled;
+
+ 	//while an entry is evaluated its items go through the queue as they
+ 	//are made, so the drawing builds up as it runs
+ 	static const size_t QUEUE_CAPACITY = 8192;
+ 	SpscQueue<QGraphicsItem *> queue;
+ 	void addGraphic(const Atom & atom);
+ 	void setLayer(const std::string & name);
+ 	bool clearLayer(const std::string & name);
+
+ 	//everything on the canvas is on a layer. entries draw on the layer
+ 	//picked with (layer name), a file draws on a layer named by its path
+ 	struct Layer
+ 	{
+ 		DisplayList graphics;
+ 		std::vector<QGraphicsItem *> items;
+ 		quint64 used;
+ 	};
+ 	std::map<QString, Layer> layers;
+ 	QString currentLayer;
+ 	quint64 entries;
+
+ 	//the layer the running evaluation draws on. a file that is already
+ 	//shown is not streamed, what it draws is collected and only the
+ 	//primitives that changed are replaced when it is done
+ 	QString target;
+ 	bool fileEntry;
+ 	bool collecting;
+ 	DisplayList collected;
+
+ 	//the undo history keeps what each step changed, a count for what was
+ 	//drawn and the primitives for what was taken away, never the items
+ 	struct Delta
+ 	{
+ 		enum Kind {Added, Cleared, Replaced};
+ 		Kind kind;
+ 		QString layer;
+ 		size_t added;
+ 		DisplayList before;
+ 	};
+ 	std::vector<Delta> pending;
+ 	std::deque<std::vector<Delta> > history;
+ 	qint64 memoryLimit;
+
+ 	void addToLayer(const QString & name, const Atom & atom, QGraphicsItem * item);
+ 	void takeLayer(const QString & name, QVector<QGraphicsItem *> & removed);
+ 	void replaceLayer(const QString & name, const DisplayList & graphics);
+ 	void revert(const std::vector<Delta> & deltas);
+ 	void commit();
+ 	void enforceLimit();
+ 	static qint64 layerBytes(const Layer & layer);
+ 	static qint64 stepBytes(const std::vector<Delta> & step);
 };
 
+Q_DECLARE_METATYPE(QVector<QGraphicsItem *>)
+
 #endif
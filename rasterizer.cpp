@@ -0,0 +1,424 @@
+// system includes
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+
+// module includes
+#include "rasterizer.hpp"
+#include "scene_graph.hpp"
+
+// The kernels below work one row at a time. They compute the coverage of
+// a run of pixels into a float array with straight line, branch free code
+// that the compiler turns into SIMD, then blend the run into the image.
+// They clamp with std::min and std::max, which are plain compare and
+// select, where fmin and fmax would have to look out for NaN.
+
+//coverage of a pixel whose center is distance away from the middle of a
+//stroke, with a one pixel wide antialiasing ramp at the edge
+static inline float strokeCoverage(float distance, float halfWidth)
+{
+    return std::min(std::max(halfWidth + 0.5f - distance, 0.0f), 1.0f);
+}
+
+//coverage of the pixels [x0, x1) on the row with center y by a disc
+static void discRow(float * coverage, int x0, int x1, float y, float cx, float cy, float radius)
+{
+    float dy = y - cy;
+    for (int x = x0; x < x1; x++)
+    {
+        float dx = x + 0.5f - cx;
+        coverage[x - x0] = strokeCoverage(std::sqrt(dx * dx + dy * dy), radius);
+    }
+}
+
+//coverage of the pixels [x0, x1) on the row with center y by the segment
+//from a to a + d, by the distance to the nearest point of the segment
+static void lineRow(float * coverage, int x0, int x1, float y, float ax, float ay, float dx, float dy,
+    float inverseLength2, float halfWidth)
+{
+    float py = y - ay;
+    for (int x = x0; x < x1; x++)
+    {
+        float px = x + 0.5f - ax;
+        float t = (px * dx + py * dy) * inverseLength2;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        float ex = px - t * dx;
+        float ey = py - t * dy;
+        coverage[x - x0] = strokeCoverage(std::sqrt(ex * ex + ey * ey), halfWidth);
+    }
+}
+
+// An arc in pixel coordinates. The start and end directions are unit
+// vectors with y pointing up, and the arc runs counter clockwise from
+// start to end. Minor arcs span at most half a turn.
+struct ArcGeometry
+{
+    float cx, cy, radius;
+    float sx, sy, ex, ey;
+    bool minor;
+};
+
+//coverage of the pixels [x0, x1) on the row with center y by an arc
+//inside the swept angle the distance is to the circle, outside it is
+//to the nearer end point
+static void arcRow(float * coverage, int x0, int x1, float y, const ArcGeometry & arc, float halfWidth)
+{
+    float dy = arc.cy - y;
+    float startX = arc.cx + arc.radius * arc.sx;
+    float startY = arc.cy - arc.radius * arc.sy;
+    float endX = arc.cx + arc.radius * arc.ex;
+    float endY = arc.cy - arc.radius * arc.ey;
+    float minor = arc.minor ? 1.0f : 0.0f;
+    for (int x = x0; x < x1; x++)
+    {
+        float px = x + 0.5f;
+        float dx = px - arc.cx;
+        float ring = std::fabs(std::sqrt(dx * dx + dy * dy) - arc.radius);
+
+        //which side of the start and end directions the pixel is on, a minor
+        //arc needs both to be right, a major arc either one
+        float afterStart = float(arc.sx * dy - arc.sy * dx >= 0.0f);
+        float beforeEnd = float(dx * arc.ey - dy * arc.ex >= 0.0f);
+        float inside = minor * afterStart * beforeEnd + (1.0f - minor) * std::min(afterStart + beforeEnd, 1.0f);
+
+        float sdx = px - startX;
+        float sdy = y - startY;
+        float edx = px - endX;
+        float edy = y - endY;
+        float ends = std::min(std::sqrt(sdx * sdx + sdy * sdy), std::sqrt(edx * edx + edy * edy));
+        coverage[x - x0] = strokeCoverage(inside * ring + (1.0f - inside) * ends, halfWidth);
+    }
+}
+
+Rasterizer::Rasterizer(int width, int height)
+{
+    imageWidth = std::max(width, 0);
+    imageHeight = std::max(height, 0);
+    scale = 1;
+    offsetX = 0;
+    offsetY = 0;
+    rgba.resize(size_t(imageWidth) * imageHeight * 4);
+    rowCoverage.resize(imageWidth);
+    clear();
+}
+
+int Rasterizer::width() const
+{
+    return imageWidth;
+}
+
+int Rasterizer::height() const
+{
+    return imageHeight;
+}
+
+void Rasterizer::fit(const Bounds & bounds, int margin)
+{
+    if (bounds.empty())
+    {
+        return;
+    }
+    double availableWidth = std::max(imageWidth - 2 * margin, 1);
+    double availableHeight = std::max(imageHeight - 2 * margin, 1);
+    if (bounds.width() > 0 && bounds.height() > 0)
+    {
+        scale = std::min(availableWidth / bounds.width(), availableHeight / bounds.height());
+    }
+    else if (bounds.width() > 0)
+    {
+        scale = availableWidth / bounds.width();
+    }
+    else if (bounds.height() > 0)
+    {
+        scale = availableHeight / bounds.height();
+    }
+    else
+    {
+        scale = 1;
+    }
+    offsetX = imageWidth / 2.0 - (bounds.left + bounds.right) / 2 * scale;
+    offsetY = imageHeight / 2.0 - (bounds.top + bounds.bottom) / 2 * scale;
+}
+
+void Rasterizer::clear()
+{
+    std::fill(rgba.begin(), rgba.end(), 255);
+}
+
+void Rasterizer::draw(const DisplayList & graphics)
+{
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        draw(graphics[i]);
+    }
+}
+
+void Rasterizer::draw(const Atom & atom)
+{
+    PixelRect all = {0, 0, imageWidth, imageHeight};
+    draw(atom, all, rowCoverage);
+}
+
+void Rasterizer::draw(const Atom & atom, const PixelRect & clip, std::vector<float> & scratch)
+{
+    if (int(scratch.size()) < imageWidth)
+    {
+        scratch.resize(imageWidth);
+    }
+
+    //only the pixels the atom can reach that are also inside the clip
+    PixelRect reach = pixelBounds(atom);
+    PixelRect area = {std::max(reach.x0, clip.x0), std::max(reach.y0, clip.y0),
+        std::min(reach.x1, clip.x1), std::min(reach.y1, clip.y1)};
+    if (area.x0 >= area.x1 || area.y0 >= area.y1)
+    {
+        return;
+    }
+
+    if (atom.type == PointType)
+    {
+        drawPoint(atom.value.point_value, area, &scratch[0]);
+    }
+    else if (atom.type == LineType)
+    {
+        drawLine(atom.value.line_value, area, &scratch[0]);
+    }
+    else if (atom.type == ArcType)
+    {
+        drawArc(atom.value.arc_value, area, &scratch[0]);
+    }
+    else if (atom.type == PolylineType || atom.type == PolygonType)
+    {
+        drawPath(atom.points(), atom.type == PolygonType, area, &scratch[0]);
+    }
+    else if (atom.type == GroupType)
+    {
+        //the atoms of the shape are moved into place one at a time as they
+        //are drawn. one whose box misses the area is skipped before it is
+        //moved, a group with everything inside it
+        const Transform & transform = atom.instance().transform;
+        const std::vector<Atom> & children = atom.instance().group->children;
+        double pad = std::max(strokeHalfWidth(), pointRadius()) + 1;
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            PixelRect child = pixelRect(transformBounds(transform, atomBounds(children[i])), pad);
+            if (std::max(child.x0, area.x0) < std::min(child.x1, area.x1)
+                && std::max(child.y0, area.y0) < std::min(child.y1, area.y1))
+            {
+                draw(transformAtom(children[i], transform), area, scratch);
+            }
+        }
+    }
+}
+
+PixelRect Rasterizer::pixelBounds(const Atom & atom) const
+{
+    //room for the pen and the antialiased edge
+    double pad = std::max(strokeHalfWidth(), atom.type == PointType ? pointRadius() : 0.0) + 1;
+    return pixelRect(atomBounds(atom), pad);
+}
+
+//the pixels within pad of bounds, clipped to the image
+PixelRect Rasterizer::pixelRect(const Bounds & bounds, double pad) const
+{
+    PixelRect rect = {0, 0, 0, 0};
+    if (bounds.empty())
+    {
+        return rect;
+    }
+    double x0 = std::floor(bounds.left * scale + offsetX - pad);
+    double y0 = std::floor(bounds.top * scale + offsetY - pad);
+    double x1 = std::ceil(bounds.right * scale + offsetX + pad);
+    double y1 = std::ceil(bounds.bottom * scale + offsetY + pad);
+    rect.x0 = int(std::max(x0, 0.0));
+    rect.y0 = int(std::max(y0, 0.0));
+    rect.x1 = int(std::min(x1, double(imageWidth)));
+    rect.y1 = int(std::min(y1, double(imageHeight)));
+    return rect;
+}
+
+const std::vector<unsigned char> & Rasterizer::pixels() const
+{
+    return rgba;
+}
+
+bool Rasterizer::writePPM(const std::string & file) const
+{
+    std::ofstream ofs(file, std::ios::binary);
+    if (!ofs.good())
+    {
+        return false;
+    }
+    ofs << "P6\n" << imageWidth << " " << imageHeight << "\n255\n";
+    std::vector<char> row(size_t(imageWidth) * 3);
+    for (int y = 0; y < imageHeight; y++)
+    {
+        const unsigned char * pixel = &rgba[size_t(y) * imageWidth * 4];
+        for (int x = 0; x < imageWidth; x++)
+        {
+            row[x * 3] = pixel[x * 4];
+            row[x * 3 + 1] = pixel[x * 4 + 1];
+            row[x * 3 + 2] = pixel[x * 4 + 2];
+        }
+        ofs.write(row.data(), row.size());
+    }
+    return ofs.good();
+}
+
+//the pen is one scene unit wide, like the canvas, but never thinner than a pixel
+double Rasterizer::strokeHalfWidth() const
+{
+    return std::max(scale, 1.0) / 2;
+}
+
+//points are circles of radius one scene unit, at least a pixel
+double Rasterizer::pointRadius() const
+{
+    return std::max(scale, 1.0);
+}
+
+//points are 2x2 circles with their top left corner at the point
+void Rasterizer::drawPoint(const Point & point, const PixelRect & clip, float * coverage)
+{
+    float cx = float((point.x + 1) * scale + offsetX);
+    float cy = float((point.y + 1) * scale + offsetY);
+    float radius = float(pointRadius());
+    for (int y = clip.y0; y < clip.y1; y++)
+    {
+        discRow(coverage, clip.x0, clip.x1, y + 0.5f, cx, cy, radius);
+        blend(y, clip.x0, clip.x1, coverage);
+    }
+}
+
+void Rasterizer::drawLine(const Line & line, const PixelRect & clip, float * coverage)
+{
+    float ax = float(line.first.x * scale + offsetX);
+    float ay = float(line.first.y * scale + offsetY);
+    float dx = float(line.second.x * scale + offsetX) - ax;
+    float dy = float(line.second.y * scale + offsetY) - ay;
+    float length2 = dx * dx + dy * dy;
+    float inverseLength2 = length2 > 0 ? 1 / length2 : 0;
+    float halfWidth = float(strokeHalfWidth());
+
+    //on each row only the pixels within reach of the infinite line are visited
+    float reach = halfWidth + 1;
+    float across = std::fabs(dy) > 1e-6f ? reach * std::sqrt(length2) / std::fabs(dy) : 0;
+    for (int y = clip.y0; y < clip.y1; y++)
+    {
+        float py = y + 0.5f;
+        int x0 = clip.x0;
+        int x1 = clip.x1;
+        if (across > 0)
+        {
+            float center = ax + (py - ay) * dx / dy;
+            x0 = std::max(x0, int(std::floor(center - across)));
+            x1 = std::min(x1, int(std::ceil(center + across)) + 1);
+        }
+        if (x0 < x1)
+        {
+            lineRow(coverage, x0, x1, py, ax, ay, dx, dy, inverseLength2, halfWidth);
+            blend(y, x0, x1, coverage);
+        }
+    }
+}
+
+//each segment is drawn as a line over only the part of clip it can reach,
+//a polygon has one more from its last vertex back to its first
+void Rasterizer::drawPath(const PointList & vertices, bool closed, const PixelRect & clip, float * coverage)
+{
+    double pad = strokeHalfWidth() + 1;
+    size_t segments = closed && vertices.size() > 2 ? vertices.size() : vertices.size() - 1;
+    for (size_t i = 0; i < segments; i++)
+    {
+        Line line;
+        line.first = vertices[i];
+        line.second = vertices[(i + 1) % vertices.size()];
+        Bounds bounds;
+        bounds.include(line.first.x, line.first.y);
+        bounds.include(line.second.x, line.second.y);
+        PixelRect reach = pixelRect(bounds, pad);
+        PixelRect area = {std::max(reach.x0, clip.x0), std::max(reach.y0, clip.y0),
+            std::min(reach.x1, clip.x1), std::min(reach.y1, clip.y1)};
+        if (area.x0 < area.x1 && area.y0 < area.y1)
+        {
+            drawLine(line, area, coverage);
+        }
+    }
+}
+
+void Rasterizer::drawArc(const Arc & arc, const PixelRect & clip, float * coverage)
+{
+    const double twoPi = 2 * atan2(0, -1);
+    double dx = arc.start.x - arc.center.x;
+    double dy = arc.start.y - arc.center.y;
+    double radius = std::sqrt(dx * dx + dy * dy);
+    double start = atan2(-dy, dx);
+    double span = arc.span;
+
+    //run counter clockwise, a clockwise arc starts at its other end
+    if (span < 0)
+    {
+        start += span;
+        span = -span;
+    }
+    //a full turn has its end on its start, which makes every direction inside
+    span = std::min(span, twoPi);
+
+    ArcGeometry geometry;
+    geometry.cx = float(arc.center.x * scale + offsetX);
+    geometry.cy = float(arc.center.y * scale + offsetY);
+    geometry.radius = float(radius * scale);
+    geometry.sx = float(cos(start));
+    geometry.sy = float(sin(start));
+    geometry.ex = float(cos(start + span));
+    geometry.ey = float(sin(start + span));
+    geometry.minor = span <= twoPi / 2;
+    float halfWidth = float(strokeHalfWidth());
+
+    //on each row only the pixels in the ring around the circle are visited
+    float outer = geometry.radius + halfWidth + 1;
+    float inner = geometry.radius - halfWidth - 1;
+    for (int y = clip.y0; y < clip.y1; y++)
+    {
+        float py = y + 0.5f;
+        float ry = py - geometry.cy;
+        if (std::fabs(ry) > outer)
+        {
+            continue;
+        }
+        float outerX = std::sqrt(outer * outer - ry * ry);
+        float innerX = inner > std::fabs(ry) ? std::sqrt(inner * inner - ry * ry) : 0;
+        int spans[2][2] = {
+            {int(std::floor(geometry.cx - outerX)), int(std::ceil(geometry.cx - innerX)) + 1},
+            {int(std::floor(geometry.cx + innerX)), int(std::ceil(geometry.cx + outerX)) + 1}};
+        if (spans[0][1] >= spans[1][0])
+        {
+            //the two sides of the ring touch, visit them as one run
+            spans[0][1] = spans[1][1];
+            spans[1][0] = spans[1][1];
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            int x0 = std::max(clip.x0, spans[i][0]);
+            int x1 = std::min(clip.x1, spans[i][1]);
+            if (x0 < x1)
+            {
+                arcRow(coverage, x0, x1, py, geometry, halfWidth);
+                blend(y, x0, x1, coverage);
+            }
+        }
+    }
+}
+
+//darkens the pixels [x0, x1) of row y by their coverage
+void Rasterizer::blend(int y, int x0, int x1, const float * coverage)
+{
+    unsigned char * pixel = &rgba[(size_t(y) * imageWidth + x0) * 4];
+    for (int i = 0; i < x1 - x0; i++)
+    {
+        float keep = 1.0f - coverage[i];
+        pixel[i * 4] = (unsigned char)(pixel[i * 4] * keep + 0.5f);
+        pixel[i * 4 + 1] = (unsigned char)(pixel[i * 4 + 1] * keep + 0.5f);
+        pixel[i * 4 + 2] = (unsigned char)(pixel[i * 4 + 2] * keep + 0.5f);
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef RASTERIZER_HPP
+#define RASTERIZER_HPP
+
+// system includes
+#include <string>
+#include <vector>
+
+// module includes
+#include "expression.hpp"
+#include "display_list.hpp"
+
+// A rectangle of pixels, x0 and y0 inclusive, x1 and y1 exclusive
+struct PixelRect
+{
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+};
+
+// Rasterizer draws display lists into an RGBA image, black on white
+// with antialiased edges. It has no dependencies beyond the standard
+// library so it can render where Qt is not installed.
+//
+// Every pixel is computed from its own coordinates only, so drawing a
+// display list clipped to pieces of the image gives exactly the same
+// bytes as drawing it into the whole image.
+class Rasterizer
+{
+public:
+
+  // a white image of width by height pixels, showing the scene unscaled
+  Rasterizer(int width, int height);
+
+  int width() const;
+  int height() const;
+
+  // scale and move the scene so bounds fill the image less margin pixels
+  // on every side, keeping the aspect ratio and centering the drawing
+  void fit(const Bounds & bounds, int margin);
+
+  // make every pixel white again
+  void clear();
+
+  // draw all atoms of a display list in order
+  void draw(const DisplayList & graphics);
+
+  // draw one point, line, arc, polyline, polygon or group atom, other
+  // atoms are ignored
+  void draw(const Atom & atom);
+
+  // draw one atom, touching only the pixels inside clip
+  // scratch is working memory and must not be shared between threads
+  void draw(const Atom & atom, const PixelRect & clip, std::vector<float> & scratch);
+
+  // the pixels an atom may touch, clipped to the image
+  PixelRect pixelBounds(const Atom & atom) const;
+
+  // the image, row by row, 4 bytes (red, green, blue, alpha) per pixel
+  const std::vector<unsigned char> & pixels() const;
+
+  // write the image as a binary PPM (P6), dropping alpha
+  bool writePPM(const std::string & file) const;
+
+private:
+
+  int imageWidth;
+  int imageHeight;
+
+  // scene to pixel mapping, pixel = scene * scale + offset
+  double scale;
+  double offsetX;
+  double offsetY;
+
+  std::vector<unsigned char> rgba;
+  std::vector<float> rowCoverage;
+
+  double strokeHalfWidth() const;
+  double pointRadius() const;
+
+  void drawPoint(const Point & point, const PixelRect & clip, float * coverage);
+  void drawLine(const Line & line, const PixelRect & clip, float * coverage);
+  void drawArc(const Arc & arc, const PixelRect & clip, float * coverage);
+  void drawPath(const PointList & vertices, bool closed, const PixelRect & clip, float * coverage);
+  PixelRect pixelRect(const Bounds & bounds, double pad) const;
+  void blend(int y, int x0, int x1, const float * coverage);
+};
+
+#endif
@@ -16,7 +16,7 @@ REPLWidget::REPLWidget(QWidget * parent): QWidget(parent)
 	slispBox ->setFont(QFont("Arial", 18));
 
 	//create a new layout and lable for the slisp
-	QLabel *slispLabel = new QLabel("slisp>");
+	slispLabel = new QLabel("slisp>");
   	slispLabel->setFont(QFont("Arial", 14));
 
   	QBoxLayout *layout = new QHBoxLayout;
@@ -83,11 +83,32 @@ bool REPLWidget::eventFilter(QObject* obj, QEvent* event)
         {
             downArrow();
         }
+        else if (keyEvent->key() == Qt::Key_Escape)
+        {
+            emit cancelRequested();
+        }
+        else if (keyEvent->matches(QKeySequence::Undo) && slispBox->text().isEmpty())
+        {
+            emit undoRequested();
+        }
         else
         {
             return QObject::eventFilter(obj, event);
         }
+        return true;
+    }
+    return QObject::eventFilter(obj, event);
+}
 
+void REPLWidget::setRunning(bool running)
+{
+    if (running)
+    {
+        slispLabel->setText(QString("running") + QChar(0x2026));
+    }
+    else
+    {
+        slispLabel->setText("slisp>");
     }
 }
 
@@ -3,6 +3,7 @@
 
 #include <QWidget>
 #include <QLineEdit>
+#include <QLabel>
 #include <QString>
 #include <QVector>
 
@@ -18,6 +19,17 @@ signals:
 
   void lineEntered(QString entry);
 
+  // escape was pressed to stop the running evaluation
+  void cancelRequested();
+
+  // ctrl+z was pressed on an empty line to undo the last entry
+  void undoRequested();
+
+public slots:
+
+  // show whether an entry is being evaluated
+  void setRunning(bool running);
+
 private slots:
 
   void changed();
@@ -26,6 +38,7 @@ private slots:
 
  private:
  QLineEdit * slispBox;
+ QLabel * slispLabel;
  std::vector<QString> pastQueries;
  int counter;
  bool eventFilter(QObject* obj, QEvent* event);
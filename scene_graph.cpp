@@ -0,0 +1,291 @@
+// system includes
+#include <cmath>
+#include <memory>
+#include <algorithm>
+
+// module includes
+#include "scene_graph.hpp"
+
+Transform identityTransform()
+{
+    Transform identity = {1, 0, 0, 1, 0, 0};
+    return identity;
+}
+
+Transform composeTransforms(const Transform & outer, const Transform & inner)
+{
+    Transform t;
+    t.a = outer.a * inner.a + outer.c * inner.b;
+    t.b = outer.b * inner.a + outer.d * inner.b;
+    t.c = outer.a * inner.c + outer.c * inner.d;
+    t.d = outer.b * inner.c + outer.d * inner.d;
+    t.e = outer.a * inner.e + outer.c * inner.f + outer.e;
+    t.f = outer.b * inner.e + outer.d * inner.f + outer.f;
+    return t;
+}
+
+Transform invertTransform(const Transform & transform)
+{
+    Number determinant = transform.a * transform.d - transform.b * transform.c;
+    Transform inverse;
+    inverse.a = transform.d / determinant;
+    inverse.b = -transform.b / determinant;
+    inverse.c = -transform.c / determinant;
+    inverse.d = transform.a / determinant;
+    inverse.e = -(inverse.a * transform.e + inverse.c * transform.f);
+    inverse.f = -(inverse.b * transform.e + inverse.d * transform.f);
+    return inverse;
+}
+
+Point transformPoint(const Transform & transform, const Point & point)
+{
+    Point moved;
+    moved.x = transform.a * point.x + transform.c * point.y + transform.e;
+    moved.y = transform.b * point.x + transform.d * point.y + transform.f;
+    return moved;
+}
+
+Bounds transformBounds(const Transform & transform, const Bounds & bounds)
+{
+    Bounds moved;
+    if (bounds.empty())
+    {
+        return moved;
+    }
+    Number xs[2] = {bounds.left, bounds.right};
+    Number ys[2] = {bounds.top, bounds.bottom};
+    for (int i = 0; i < 4; i++)
+    {
+        Point corner = {xs[i % 2], ys[i / 2]};
+        corner = transformPoint(transform, corner);
+        moved.include(corner.x, corner.y);
+    }
+    return moved;
+}
+
+std::shared_ptr<const Group> makeGroup(const std::vector<Atom> & children)
+{
+    std::shared_ptr<Group> group = std::make_shared<Group>();
+    group->children = children;
+    Bounds bounds;
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        bounds.include(atomBounds(children[i]));
+    }
+    group->left = bounds.left;
+    group->top = bounds.top;
+    group->right = bounds.right;
+    group->bottom = bounds.bottom;
+    return group;
+}
+
+Bounds groupBounds(const Group & group)
+{
+    Bounds bounds;
+    bounds.left = group.left;
+    bounds.top = group.top;
+    bounds.right = group.right;
+    bounds.bottom = group.bottom;
+    return bounds;
+}
+
+Atom transformAtom(const Atom & atom, const Transform & transform)
+{
+    Atom moved;
+    moved.type = atom.type;
+    if (atom.type == PointType)
+    {
+        moved.value.point_value = transformPoint(transform, atom.value.point_value);
+    }
+    else if (atom.type == LineType)
+    {
+        moved.value.line_value.first = transformPoint(transform, atom.value.line_value.first);
+        moved.value.line_value.second = transformPoint(transform, atom.value.line_value.second);
+    }
+    else if (atom.type == ArcType)
+    {
+        //a mirror image turns the other way
+        moved.value.arc_value.center = transformPoint(transform, atom.value.arc_value.center);
+        moved.value.arc_value.start = transformPoint(transform, atom.value.arc_value.start);
+        bool mirrored = transform.a * transform.d - transform.b * transform.c < 0;
+        moved.value.arc_value.span = mirrored ? -atom.value.arc_value.span : atom.value.arc_value.span;
+    }
+    else if (atom.type == PolylineType || atom.type == PolygonType)
+    {
+        const PointList & vertices = atom.points();
+        std::shared_ptr<PointList> points = std::make_shared<PointList>(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            (*points)[i] = transformPoint(transform, vertices[i]);
+        }
+        moved.value.shared_value = points;
+    }
+    else if (atom.type == GroupType)
+    {
+        const Instance & instance = atom.instance();
+        moved.value.shared_value = std::make_shared<const Instance>(
+            Instance{instance.group, composeTransforms(transform, instance.transform)});
+    }
+    return moved;
+}
+
+//expands atom moved by transform onto the end of out
+static void flattenAtom(const Atom & atom, const Transform & transform, DisplayList & out)
+{
+    if (atom.type != GroupType)
+    {
+        out.push_back(transformAtom(atom, transform));
+        return;
+    }
+    Transform inner = composeTransforms(transform, atom.instance().transform);
+    const std::vector<Atom> & children = atom.instance().group->children;
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        flattenAtom(children[i], inner, out);
+    }
+}
+
+DisplayList flattenDisplayList(const DisplayList & graphics)
+{
+    DisplayList flat;
+    flat.reserve(graphics.size());
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        if (graphics[i].type == GroupType)
+        {
+            flattenAtom(graphics[i], identityTransform(), flat);
+        }
+        else
+        {
+            flat.push_back(graphics[i]);
+        }
+    }
+    return flat;
+}
+
+//whether point is inside bounds grown by tolerance
+static bool near(const Bounds & bounds, const Point & point, Number tolerance)
+{
+    return !bounds.empty() && point.x >= bounds.left - tolerance && point.x <= bounds.right + tolerance
+        && point.y >= bounds.top - tolerance && point.y <= bounds.bottom + tolerance;
+}
+
+//how far point is from the segment from a to b
+static Number segmentDistance(const Point & point, const Point & a, const Point & b)
+{
+    Number dx = b.x - a.x, dy = b.y - a.y;
+    Number length2 = dx * dx + dy * dy;
+    Number t = length2 > 0 ? ((point.x - a.x) * dx + (point.y - a.y) * dy) / length2 : 0;
+    t = std::max(Number(0), std::min(Number(1), t));
+    Number ex = a.x + t * dx - point.x, ey = a.y + t * dy - point.y;
+    return std::sqrt(ex * ex + ey * ey);
+}
+
+//whether point is near the circle of an arc and inside the angles it
+//sweeps, or near one of its ends
+static bool hitArc(const Arc & arc, const Point & point, Number tolerance)
+{
+    const Number twoPi = 2 * std::atan2(0, -1);
+    Number rx = arc.start.x - arc.center.x, ry = arc.start.y - arc.center.y;
+    Number px = point.x - arc.center.x, py = point.y - arc.center.y;
+    Number radius = std::sqrt(rx * rx + ry * ry);
+    if (std::fabs(std::sqrt(px * px + py * py) - radius) > tolerance)
+    {
+        return false;
+    }
+    if (std::fabs(arc.span) >= twoPi)
+    {
+        return true;
+    }
+    //angles counter clockwise on screen, y grows downward
+    Number start = std::atan2(-ry, rx);
+    Number low = arc.span < 0 ? start + arc.span : start;
+    Number angle = std::atan2(-py, px) - low;
+    angle -= twoPi * std::floor(angle / twoPi);
+    if (angle <= std::fabs(arc.span))
+    {
+        return true;
+    }
+    Point end = {arc.center.x + radius * std::cos(start + arc.span),
+                 arc.center.y - radius * std::sin(start + arc.span)};
+    return segmentDistance(point, arc.start, arc.start) <= tolerance
+        || segmentDistance(point, end, end) <= tolerance;
+}
+
+bool hitAtom(const Atom & atom, const Point & point, Number tolerance)
+{
+    if (atom.type == PointType)
+    {
+        //the 2x2 circle
+        Point center = {atom.value.point_value.x + 1, atom.value.point_value.y + 1};
+        return segmentDistance(point, center, center) <= 1 + tolerance;
+    }
+    if (atom.type == LineType)
+    {
+        return segmentDistance(point, atom.value.line_value.first, atom.value.line_value.second) <= tolerance;
+    }
+    if (atom.type == ArcType)
+    {
+        return hitArc(atom.value.arc_value, point, tolerance);
+    }
+    if (atom.type == PolylineType || atom.type == PolygonType)
+    {
+        const PointList & vertices = atom.points();
+        size_t segments = atom.type == PolygonType && vertices.size() > 2 ? vertices.size() : vertices.size() - 1;
+        for (size_t i = 0; i < segments; i++)
+        {
+            if (segmentDistance(point, vertices[i], vertices[(i + 1) % vertices.size()]) <= tolerance)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (atom.type == GroupType)
+    {
+        //nothing inside is looked at unless the box is hit, then the point
+        //and tolerance are taken into the group's own coordinates
+        const Instance & instance = atom.instance();
+        const Transform & transform = instance.transform;
+        if (!near(transformBounds(transform, groupBounds(*instance.group)), point, tolerance))
+        {
+            return false;
+        }
+        Number scale = std::sqrt(std::fabs(transform.a * transform.d - transform.b * transform.c));
+        if (scale == 0)
+        {
+            return false;
+        }
+        Point local = transformPoint(invertTransform(transform), point);
+        return hitGroup(*instance.group, local, tolerance / scale);
+    }
+    return false;
+}
+
+bool hitGroup(const Group & group, const Point & point, Number tolerance)
+{
+    if (!near(groupBounds(group), point, tolerance))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < group.children.size(); i++)
+    {
+        if (hitAtom(group.children[i], point, tolerance))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t hitTest(const DisplayList & graphics, const Point & point, Number tolerance)
+{
+    for (size_t i = graphics.size(); i > 0; i--)
+    {
+        if (hitAtom(graphics[i - 1], point, tolerance))
+        {
+            return i - 1;
+        }
+    }
+    return HIT_NONE;
+}
@@ -0,0 +1,66 @@
+#ifndef SCENE_GRAPH_HPP
+#define SCENE_GRAPH_HPP
+
+// system includes
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+// module includes
+#include "display_list.hpp"
+
+// A display list is a scene graph: a group atom draws a shared Group of
+// atoms, which may be groups again, through its transform. Every Group
+// knows the box around its children, worked out once when it is made.
+// A Group never changes, so the box never goes stale, different children
+// make a new Group.
+//
+// Only rotations, uniform scales and translations are made (see
+// procTranslate), so arcs stay circular under any transform. Points keep
+// their 2x2 size wherever they are moved.
+
+// the transform that leaves everything where it is
+Transform identityTransform();
+
+// the transform that applies inner and then outer
+Transform composeTransforms(const Transform & outer, const Transform & inner);
+
+// the transform that undoes transform, which must not flatten everything
+Transform invertTransform(const Transform & transform);
+
+Point transformPoint(const Transform & transform, const Point & point);
+
+// the box around bounds once it is transformed, larger than needed when
+// the transform turns it
+Bounds transformBounds(const Transform & transform, const Bounds & bounds);
+
+// a group of children with the box around them worked out
+std::shared_ptr<const Group> makeGroup(const std::vector<Atom> & children);
+
+// the box around the children of a group, before its transform
+Bounds groupBounds(const Group & group);
+
+// an atom moved by transform. a group keeps sharing its atoms, transform
+// is only put in front of its own
+Atom transformAtom(const Atom & atom, const Transform & transform);
+
+// the primitives a display list draws with every group expanded, for
+// writers that have no way to share geometry
+DisplayList flattenDisplayList(const DisplayList & graphics);
+
+// whether an atom passes within tolerance of point. a group is only
+// looked into if its box does
+bool hitAtom(const Atom & atom, const Point & point, Number tolerance);
+
+// whether any atom of a group passes within tolerance of point, given in
+// the coordinates of the group's children
+bool hitGroup(const Group & group, const Point & point, Number tolerance);
+
+// marks a point that no atom passes near
+const size_t HIT_NONE = size_t(-1);
+
+// the index of the atom drawn last, so on top, that passes within
+// tolerance of point, or HIT_NONE
+size_t hitTest(const DisplayList & graphics, const Point & point, Number tolerance);
+
+#endif
@@ -0,0 +1,265 @@
+// system includes
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+
+// module includes
+#include "sld_format.hpp"
+#include "scene_graph.hpp"
+
+static_assert(sizeof(SldHeader) == 80, "the .sld header must be packed into 80 bytes");
+static_assert(offsetof(SldHeader, pathCount) == SLD_V1_HEADER_SIZE, "version 1 headers must be a prefix");
+
+//the header and records are written as they are laid out in memory
+static bool littleEndian()
+{
+    uint32_t one = 1;
+    unsigned char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+static void writeDoubles(std::ofstream & out, const double * values, size_t count)
+{
+    out.write(reinterpret_cast<const char *>(values), count * sizeof(double));
+}
+
+bool writeSld(const std::string & file, const DisplayList & graphics)
+{
+    if (!littleEndian())
+    {
+        return false;
+    }
+    //the format has no shared shapes, groups go in as what they draw
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        if (graphics[i].type == GroupType)
+        {
+            return writeSld(file, flattenDisplayList(graphics));
+        }
+    }
+    SldHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SLD_MAGIC, sizeof(header.magic));
+    header.version = SLD_VERSION;
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        header.pointCount += graphics[i].type == PointType;
+        header.lineCount += graphics[i].type == LineType;
+        header.arcCount += graphics[i].type == ArcType;
+        if (graphics[i].type == PolylineType || graphics[i].type == PolygonType)
+        {
+            header.pathCount++;
+            header.vertexCount += graphics[i].points().size();
+        }
+    }
+    Bounds bounds = displayListBounds(graphics);
+    if (!bounds.empty())
+    {
+        header.left = bounds.left;
+        header.top = bounds.top;
+        header.right = bounds.right;
+        header.bottom = bounds.bottom;
+    }
+
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if (!out.good())
+    {
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    //one pass per type keeps each array contiguous
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        if (graphics[i].type == PointType)
+        {
+            const Point & point = graphics[i].value.point_value;
+            double record[SLD_POINT_FIELDS] = {point.x, point.y};
+            writeDoubles(out, record, SLD_POINT_FIELDS);
+        }
+    }
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        if (graphics[i].type == LineType)
+        {
+            const Line & line = graphics[i].value.line_value;
+            double record[SLD_LINE_FIELDS] = {line.first.x, line.first.y, line.second.x, line.second.y};
+            writeDoubles(out, record, SLD_LINE_FIELDS);
+        }
+    }
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        if (graphics[i].type == ArcType)
+        {
+            const Arc & arc = graphics[i].value.arc_value;
+            double record[SLD_ARC_FIELDS] = {arc.center.x, arc.center.y, arc.start.x, arc.start.y, arc.span};
+            writeDoubles(out, record, SLD_ARC_FIELDS);
+        }
+    }
+    uint64_t firstVertex = 0;
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        if (graphics[i].type == PolylineType || graphics[i].type == PolygonType)
+        {
+            size_t count = graphics[i].points().size();
+            double record[SLD_PATH_FIELDS] = {double(firstVertex), double(count),
+                graphics[i].type == PolygonType ? 1.0 : 0.0};
+            writeDoubles(out, record, SLD_PATH_FIELDS);
+            firstVertex += count;
+        }
+    }
+    //a point is two packed doubles, so a path's vertices go out in one write
+    static_assert(sizeof(Point) == SLD_VERTEX_FIELDS * sizeof(double), "points must be packed");
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        if (graphics[i].type == PolylineType || graphics[i].type == PolygonType)
+        {
+            const PointList & vertices = graphics[i].points();
+            writeDoubles(out, &vertices[0].x, vertices.size() * SLD_VERTEX_FIELDS);
+        }
+    }
+    out.close();
+    return !out.fail();
+}
+
+SldView::SldView(): header(nullptr), points(nullptr), lines(nullptr), arcs(nullptr), paths(nullptr),
+    vertices(nullptr), pathCount(0), vertexCount(0)
+{
+}
+
+bool SldView::attach(const void * data, size_t size, std::string & error)
+{
+    header = nullptr;
+    const SldHeader * head = static_cast<const SldHeader *>(data);
+    if (size < SLD_V1_HEADER_SIZE || std::memcmp(head->magic, SLD_MAGIC, sizeof(head->magic)) != 0)
+    {
+        error = "Error: not a .sld file";
+        return false;
+    }
+    if (head->version < 1 || head->version > SLD_VERSION || !littleEndian())
+    {
+        error = "Error: unsupported .sld version";
+        return false;
+    }
+    //a version 1 header stops before the path counts
+    size_t headerSize = head->version == 1 ? SLD_V1_HEADER_SIZE : sizeof(SldHeader);
+    if (size < headerSize)
+    {
+        error = "Error: truncated .sld file";
+        return false;
+    }
+    uint64_t pathRecords = head->version == 1 ? 0 : head->pathCount;
+    uint64_t vertexRecords = head->version == 1 ? 0 : head->vertexCount;
+
+    //compare record counts rather than byte sizes so huge counts cannot overflow
+    uint64_t records = (size - headerSize) / sizeof(double);
+    if (head->pointCount > records / SLD_POINT_FIELDS || head->lineCount > records / SLD_LINE_FIELDS
+        || head->arcCount > records / SLD_ARC_FIELDS || pathRecords > records / SLD_PATH_FIELDS
+        || vertexRecords > records / SLD_VERTEX_FIELDS
+        || head->pointCount * SLD_POINT_FIELDS + head->lineCount * SLD_LINE_FIELDS
+           + head->arcCount * SLD_ARC_FIELDS + pathRecords * SLD_PATH_FIELDS
+           + vertexRecords * SLD_VERTEX_FIELDS > records)
+    {
+        error = "Error: truncated .sld file";
+        return false;
+    }
+    const double * start = reinterpret_cast<const double *>(static_cast<const char *>(data) + headerSize);
+    const double * pathStart = start + head->pointCount * SLD_POINT_FIELDS + head->lineCount * SLD_LINE_FIELDS
+        + head->arcCount * SLD_ARC_FIELDS;
+    const double * vertexStart = pathStart + pathRecords * SLD_PATH_FIELDS;
+
+    //every path has to stay inside the vertices
+    for (uint64_t i = 0; i < pathRecords; i++)
+    {
+        const double * record = pathStart + i * SLD_PATH_FIELDS;
+        if (!(record[0] >= 0 && record[1] >= 2 && record[0] + record[1] <= double(vertexRecords)
+              && (record[2] == 0 || record[2] == 1)))
+        {
+            error = "Error: corrupt .sld path";
+            return false;
+        }
+    }
+    header = head;
+    points = start;
+    lines = points + head->pointCount * SLD_POINT_FIELDS;
+    arcs = lines + head->lineCount * SLD_LINE_FIELDS;
+    paths = pathStart;
+    vertices = vertexStart;
+    pathCount = pathRecords;
+    vertexCount = vertexRecords;
+    return true;
+}
+
+size_t SldView::size() const
+{
+    if (!header)
+    {
+        return 0;
+    }
+    return header->pointCount + header->lineCount + header->arcCount + pathCount;
+}
+
+Atom SldView::atom(size_t index) const
+{
+    Atom a;
+    if (index < header->pointCount)
+    {
+        const double * record = points + index * SLD_POINT_FIELDS;
+        a.type = PointType;
+        a.value.point_value.x = record[0];
+        a.value.point_value.y = record[1];
+        return a;
+    }
+    index -= header->pointCount;
+    if (index < header->lineCount)
+    {
+        const double * record = lines + index * SLD_LINE_FIELDS;
+        a.type = LineType;
+        a.value.line_value.first.x = record[0];
+        a.value.line_value.first.y = record[1];
+        a.value.line_value.second.x = record[2];
+        a.value.line_value.second.y = record[3];
+        return a;
+    }
+    index -= header->lineCount;
+    if (index >= header->arcCount)
+    {
+        const double * record = paths + (index - header->arcCount) * SLD_PATH_FIELDS;
+        const Point * first = reinterpret_cast<const Point *>(vertices + size_t(record[0]) * SLD_VERTEX_FIELDS);
+        a.type = record[2] == 1 ? PolygonType : PolylineType;
+        a.value.shared_value = std::make_shared<const PointList>(first, first + size_t(record[1]));
+        return a;
+    }
+    const double * record = arcs + index * SLD_ARC_FIELDS;
+    a.type = ArcType;
+    a.value.arc_value.center.x = record[0];
+    a.value.arc_value.center.y = record[1];
+    a.value.arc_value.start.x = record[2];
+    a.value.arc_value.start.y = record[3];
+    a.value.arc_value.span = record[4];
+    return a;
+}
+
+Bounds SldView::bounds() const
+{
+    Bounds bounds;
+    if (size() > 0)
+    {
+        bounds.include(header->left, header->top);
+        bounds.include(header->right, header->bottom);
+    }
+    return bounds;
+}
+
+DisplayList SldView::displayList() const
+{
+    DisplayList graphics;
+    graphics.reserve(size());
+    for (size_t i = 0; i < size(); i++)
+    {
+        graphics.push_back(atom(i));
+    }
+    return graphics;
+}
@@ -0,0 +1,103 @@
+#ifndef SLD_FORMAT_HPP
+#define SLD_FORMAT_HPP
+
+// system includes
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// module includes
+#include "display_list.hpp"
+
+// The .sld format stores evaluated geometry so it can be viewed without
+// running the program again. All numbers are little endian.
+//
+//   SldHeader     80 bytes
+//   points        pointCount records of x y
+//   lines         lineCount records of x1 y1 x2 y2
+//   arcs          arcCount records of centerx centery startx starty span
+//   paths         pathCount records of firstVertex vertexCount closed
+//   vertices      vertexCount records of x y
+//
+// every record field is a double and every array starts on an 8 byte
+// boundary, so a mapped file can be read in place. The primitives are
+// grouped by type, drawing order within a type is kept. A path is a
+// polyline, or a polygon if closed is 1, through its run of vertices.
+//
+// Groups are written as the primitives they draw, moved into place.
+//
+// Version 1 files have no paths, their header ends after the bounds at
+// 64 bytes, and they are still read.
+
+const char SLD_MAGIC[4] = {'S', 'L', 'D', '\0'};
+const uint32_t SLD_VERSION = 2;
+
+// doubles per record
+const size_t SLD_POINT_FIELDS = 2;
+const size_t SLD_LINE_FIELDS = 4;
+const size_t SLD_ARC_FIELDS = 5;
+const size_t SLD_PATH_FIELDS = 3;
+const size_t SLD_VERTEX_FIELDS = 2;
+
+// the header size of version 1 files
+const size_t SLD_V1_HEADER_SIZE = 64;
+
+struct SldHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint64_t pointCount;
+  uint64_t lineCount;
+  uint64_t arcCount;
+  // the bounds of the drawing, all zero if it is empty
+  double left;
+  double top;
+  double right;
+  double bottom;
+  // since version 2
+  uint64_t pathCount;
+  uint64_t vertexCount;
+};
+
+// write a display list as a .sld file, false if it cannot be written
+bool writeSld(const std::string & file, const DisplayList & graphics);
+
+// SldView reads the primitives of a .sld image that is already in memory,
+// typically a mapped file, without copying it
+class SldView
+{
+public:
+
+  SldView();
+
+  // check that data holds a complete .sld image of this or an earlier
+  // version and read from it, data must be 8 byte aligned and outlive the
+  // view
+  // returns false and sets error if it does not
+  bool attach(const void * data, size_t size, std::string & error);
+
+  // the number of primitives
+  size_t size() const;
+
+  // primitive index as an atom, points first, then lines, arcs and paths
+  Atom atom(size_t index) const;
+
+  // the bounds stored in the header
+  Bounds bounds() const;
+
+  // all primitives as a display list
+  DisplayList displayList() const;
+
+private:
+
+  const SldHeader * header;
+  const double * points;
+  const double * lines;
+  const double * arcs;
+  const double * paths;
+  const double * vertices;
+  uint64_t pathCount;
+  uint64_t vertexCount;
+};
+
+#endif
@@ -1,29 +1,136 @@
 #include <string>
 #include <iostream>
+#include <sstream>
 
 #include <QApplication>
 #include <QDebug>
 
 #include "main_window.hpp"
+#include "offscreen_renderer.hpp"
+
+// parse a size of the form WxH
+static bool parseSize(const std::string & text, QSize & size)
+{
+    std::istringstream iss(text);
+    int width = 0, height = 0;
+    char x = 0;
+    if (!(iss >> width >> x >> height) || x != 'x' || !iss.eof() || width <= 0 || height <= 0)
+    {
+        return false;
+    }
+    size = QSize(width, height);
+    return true;
+}
+
+// sldraw --render out.png [--size WxH] script.slp
+// rasterize the script into an image without opening a window
+static int render(int argc, char *argv[])
+{
+    std::string out, script;
+    QSize size(800, 600);
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--render" && i + 1 < argc)
+        {
+            out = argv[++i];
+        }
+        else if (arg == "--size" && i + 1 < argc)
+        {
+            if (!parseSize(argv[++i], size))
+            {
+                std::cerr << "Error: invalid size, expected WxH" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (script.empty())
+        {
+            script = arg;
+        }
+        else
+        {
+            std::cerr << "Error: invalid arguments to sldraw --render" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (out.empty() || script.empty())
+    {
+        std::cerr << "Error: usage is sldraw --render out.png [--size WxH] script.slp" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //no window is ever shown, so there is no need for a display
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    std::string error;
+    if (!renderScriptToFile(script, out, size, error))
+    {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
 
 int main(int argc, char *argv[])
 {
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--render")
+        {
+            return render(argc, argv);
+        }
+    }
+
     QApplication app(argc, argv);
 
     std::string filename;
+    bool watch = false;
+    qint64 memoryLimit = 0;
 
-    if (argc == 2)
+    // sldraw --watch script.slp redraws the script every time it is saved
+    // sldraw --memory-limit MB keeps the drawing and its undo history under MB
+    for (int i = 1; i < argc; i++)
     {
-      filename = argv[1];
+        std::string arg = argv[i];
+        if (arg == "--watch")
+        {
+            watch = true;
+        }
+        else if (arg == "--memory-limit" && i + 1 < argc)
+        {
+            std::istringstream iss(argv[++i]);
+            if (!(iss >> memoryLimit) || !iss.eof() || memoryLimit <= 0)
+            {
+                std::cerr << "Error: invalid memory limit, expected megabytes" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (filename.empty())
+        {
+            filename = arg;
+        }
+        else
+        {
+            std::cerr << "Error: invalid number of arguments to sldraw" << std::endl;
+            return EXIT_FAILURE;
+        }
     }
-
-    if(argc > 2)
+    if (watch && filename.empty())
     {
-        std::cerr << "Error: invalid number of arguments to sldraw" << std::endl;
+        std::cerr << "Error: usage is sldraw --watch script.slp" << std::endl;
         return EXIT_FAILURE;
     }
 
-    MainWindow w(filename);
+    MainWindow w(watch ? "" : filename);
+    if (memoryLimit > 0)
+    {
+        w.setMemoryLimit(memoryLimit << 20);
+    }
+    if (watch)
+    {
+        w.watch(filename);
+    }
     w.setMinimumSize(800,600);
     w.show();
 
@@ -4,15 +4,32 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 // module includes
 #include "tokenize.hpp"
 #include "expression.hpp"
 #include "environment.hpp"
 #include "interpreter.hpp"
+#include "display_list.hpp"
+#include "rasterizer.hpp"
+#include "tile_rasterizer.hpp"
+#include "svg_writer.hpp"
+#include "sld_format.hpp"
+#include "display_list_optimizer.hpp"
+#include "memo_cache.hpp"
+
+// with --memo every interpreter keeps the values of pure builtins like sin
+// and pow here, they all run on the main thread
+static MemoCache * memo = nullptr;
 
 static Expression run(const std::string & program, Interpreter &interp, bool &caught)
 {
+	if (memo)
+	{
+		interp.setMemoCache(memo);
+	}
   	std::istringstream iss(program); 
     Expression result;
   	bool ok = interp.parse(iss);
@@ -35,6 +52,10 @@ static Expression run(const std::string & program, Interpreter &interp, bool &ca
 
 Expression runfile(const std::string & fname, Interpreter &interp, bool &caught)
 {
+	if (memo)
+	{
+		interp.setMemoCache(memo);
+	}
   	std::ifstream ifs(fname);
   	if (!ifs.good())
   	{
@@ -80,11 +101,298 @@ void print(Expression exp)
 	else if (exp.head.type == SymbolType)
 	{
 		std::cout << "(" << exp.head.value.sym_value << ")" <<  std::endl;
-	}	
+	}
+	else if (exp.head.type == ListType)
+	{
+		//a long list is cut short
+		const NumberList & values = exp.head.list();
+		std::cout << "(";
+		for (size_t i = 0; i < values.size() && i < 10; i++)
+		{
+			std::cout << (i ? " " : "") << values[i];
+		}
+		std::cout << (values.size() > 10 ? " ...)" : ")") << std::endl;
+	}
+	else if (exp.head.type == LambdaType)
+	{
+		std::cout << "(procedure)" <<  std::endl;
+	}
+}
+
+// parse a size of the form WxH
+static bool parseSize(const std::string & text, int & width, int & height)
+{
+	std::istringstream iss(text);
+	char x = 0;
+	if (!(iss >> width >> x >> height) || x != 'x' || !iss.eof() || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+	return true;
+}
+
+// report how much the memo cache was used, if it was on, and pass status on
+static int finish(int status)
+{
+	if (memo)
+	{
+		std::cerr << "memo cache: " << memo->hits() << " hits, " << memo->misses() << " misses" << std::endl;
+	}
+	return status;
+}
+
+// run the optimizer over what a script drew and report what it did
+static OptimizedDisplayList optimize(const DisplayList & graphics)
+{
+	OptimizedDisplayList optimized = optimizeDisplayList(graphics);
+	const OptimizerStats & stats = optimized.stats;
+	std::cerr << "optimized " << stats.input << " primitives to " << stats.output
+		<< " (" << stats.ratio() * 100 << "%): " << stats.duplicates << " duplicates, "
+		<< stats.merged << " merged, " << stats.polylines << " polylines, in "
+		<< stats.seconds * 1000 << " ms" << std::endl;
+	return optimized;
+}
+
+// slisp --render out.ppm [--size WxH] [--threads N] [--optimize] script.slp
+// rasterize what the script draws into a PPM image, on all cores unless
+// --threads says otherwise
+static int render(int argc, char **argv)
+{
+	std::string out, script;
+	int width = 800, height = 600;
+	int threads = 0;
+	bool optimizeFirst = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--render" && i + 1 < argc)
+		{
+			out = argv[++i];
+		}
+		else if (arg == "--optimize")
+		{
+			optimizeFirst = true;
+		}
+		else if (arg == "--size" && i + 1 < argc)
+		{
+			if (!parseSize(argv[++i], width, height))
+			{
+				std::cerr << "Error: invalid size, expected WxH" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (arg == "--threads" && i + 1 < argc)
+		{
+			std::istringstream iss(argv[++i]);
+			if (!(iss >> threads) || threads < 1 || !iss.eof())
+			{
+				std::cerr << "Error: invalid number of threads" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (script.empty())
+		{
+			script = arg;
+		}
+		else
+		{
+			std::cerr << "Error: invalid arguments to slisp --render" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if (out.empty() || script.empty())
+	{
+		std::cerr << "Error: usage is slisp --render out.ppm [--size WxH] [--threads N] [--optimize] script.slp" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	Interpreter interp;
+	bool caught = false;
+	runfile(script, interp, caught);
+	if (caught)
+	{
+		return EXIT_FAILURE;
+	}
+	interp.setGraphics();
+	DisplayList graphics = interp.getGraphics();
+	if (optimizeFirst)
+	{
+		graphics = optimize(graphics).graphics;
+	}
+	Rasterizer raster(width, height);
+	raster.fit(displayListBounds(graphics), 10);
+	ThreadPool pool(threads);
+	drawTiled(raster, graphics, pool);
+	if (!raster.writePPM(out))
+	{
+		std::cerr << "Error: could not write image " << out << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
 }
 
+// slisp --svg out.svg [--optimize] script.slp
+// stream what the script draws into an SVG file as it is drawn, or with
+// --optimize keep it all and write the optimized drawing at the end
+static int svg(int argc, char **argv)
+{
+	std::string out, script;
+	bool optimizeFirst = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--svg" && i + 1 < argc)
+		{
+			out = argv[++i];
+		}
+		else if (arg == "--optimize")
+		{
+			optimizeFirst = true;
+		}
+		else if (script.empty())
+		{
+			script = arg;
+		}
+		else
+		{
+			std::cerr << "Error: invalid arguments to slisp --svg" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if (out.empty() || script.empty())
+	{
+		std::cerr << "Error: usage is slisp --svg out.svg [--optimize] script.slp" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (optimizeFirst)
+	{
+		Interpreter interp;
+		bool caught = false;
+		runfile(script, interp, caught);
+		if (caught)
+		{
+			return EXIT_FAILURE;
+		}
+		interp.setGraphics();
+		if (!writeSvg(out, optimize(interp.getGraphics())))
+		{
+			std::cerr << "Error: could not write image " << out << std::endl;
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	SvgWriter writer;
+	if (!writer.open(out))
+	{
+		std::cerr << "Error: could not write image " << out << std::endl;
+		return EXIT_FAILURE;
+	}
+	Interpreter interp;
+	interp.setGraphicsSink(&writer);
+	bool caught = false;
+	runfile(script, interp, caught);
+	if (!writer.close())
+	{
+		std::cerr << "Error: could not write image " << out << std::endl;
+		return EXIT_FAILURE;
+	}
+	return caught ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// slisp --sld out.sld script.slp
+// save what the script draws as a .sld file that sldraw opens without
+// running the script again
+static int sld(int argc, char **argv)
+{
+	std::string out, script;
+	bool optimizeFirst = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--sld" && i + 1 < argc)
+		{
+			out = argv[++i];
+		}
+		else if (arg == "--optimize")
+		{
+			optimizeFirst = true;
+		}
+		else if (script.empty())
+		{
+			script = arg;
+		}
+		else
+		{
+			std::cerr << "Error: invalid arguments to slisp --sld" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if (out.empty() || script.empty())
+	{
+		std::cerr << "Error: usage is slisp --sld out.sld [--optimize] script.slp" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	Interpreter interp;
+	bool caught = false;
+	runfile(script, interp, caught);
+	if (caught)
+	{
+		return EXIT_FAILURE;
+	}
+	interp.setGraphics();
+	DisplayList graphics = interp.getGraphics();
+	if (optimizeFirst)
+	{
+		graphics = optimize(graphics).graphics;
+	}
+	if (!writeSld(out, graphics))
+	{
+		std::cerr << "Error: could not write " << out << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+// slisp [--memo] ...
+// --memo goes with any of the ways to run slisp below
 int main(int argc, char **argv)
 {
+	std::vector<char *> args;
+	std::unique_ptr<MemoCache> cache;
+	for (int i = 0; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--memo")
+		{
+			cache.reset(new MemoCache);
+			memo = cache.get();
+		}
+		else
+		{
+			args.push_back(argv[i]);
+		}
+	}
+	argc = int(args.size());
+	argv = args.data();
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--render")
+		{
+			return finish(render(argc, argv));
+		}
+		if (std::string(argv[i]) == "--svg")
+		{
+			return finish(svg(argc, argv));
+		}
+		if (std::string(argv[i]) == "--sld")
+		{
+			return finish(sld(argc, argv));
+		}
+	}
+
 	Expression result;
 	Interpreter interp;
 	bool caught;
@@ -118,7 +426,7 @@ int main(int argc, char **argv)
 				if (!caught)
 				{
 					print(result);
-					return EXIT_SUCCESS;
+					return finish(EXIT_SUCCESS);
 				}	
 			}
 			else
@@ -137,10 +445,11 @@ int main(int argc, char **argv)
 			if (!caught)
 			{
 				print(result);
-				return EXIT_SUCCESS;
+				return finish(EXIT_SUCCESS);
 			}
 
 		}
 		
 	}
+	return finish(EXIT_SUCCESS);
 }
@@ -0,0 +1,117 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+// system includes
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// A SpscQueue is a bounded ring buffer between exactly one producer thread
+// and one consumer thread. Neither side ever takes a lock, the producer
+// only writes tail and the consumer only writes head, and each side keeps
+// a private copy of the other's index so it only reads the shared one when
+// the ring looks full or empty.
+//
+// The queue never grows and never overwrites, a push to a full queue
+// fails and leaves it to the producer to wait or give up.
+template <typename T>
+class SpscQueue
+{
+public:
+
+  // a queue holding at least capacity values, rounded up to a power of two
+  explicit SpscQueue(size_t capacity);
+
+  // the number of values the queue can hold
+  size_t capacity() const;
+
+  // producer side: append value, false if the queue is full
+  bool tryPush(const T & value);
+
+  // consumer side: take the oldest value, false if the queue is empty
+  bool tryPop(T & value);
+
+  // consumer side: true if there is nothing to take
+  bool empty() const;
+
+private:
+
+  static const size_t CACHE_LINE = 64;
+
+  std::vector<T> slots;
+  size_t mask;
+  char slotsPad[CACHE_LINE];
+
+  //the indices only ever grow, a slot is index & mask. each one sits on
+  //its own cache line next to the copy its owner keeps of the other
+  std::atomic<size_t> head;
+  size_t cachedTail;
+  char headPad[CACHE_LINE];
+  std::atomic<size_t> tail;
+  size_t cachedHead;
+  char tailPad[CACHE_LINE];
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t capacity)
+{
+  size_t size = 1;
+  while (size < capacity)
+  {
+    size *= 2;
+  }
+  slots.resize(size);
+  mask = size - 1;
+  head = 0;
+  tail = 0;
+  cachedHead = 0;
+  cachedTail = 0;
+}
+
+template <typename T>
+size_t SpscQueue<T>::capacity() const
+{
+  return slots.size();
+}
+
+template <typename T>
+bool SpscQueue<T>::tryPush(const T & value)
+{
+  size_t index = tail.load(std::memory_order_relaxed);
+  if (index - cachedHead == slots.size())
+  {
+    cachedHead = head.load(std::memory_order_acquire);
+    if (index - cachedHead == slots.size())
+    {
+      return false;
+    }
+  }
+  slots[index & mask] = value;
+  tail.store(index + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::tryPop(T & value)
+{
+  size_t index = head.load(std::memory_order_relaxed);
+  if (index == cachedTail)
+  {
+    cachedTail = tail.load(std::memory_order_acquire);
+    if (index == cachedTail)
+    {
+      return false;
+    }
+  }
+  value = slots[index & mask];
+  head.store(index + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::empty() const
+{
+  return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+}
+
+#endif
@@ -0,0 +1,348 @@
+// system includes
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+// module includes
+#include "svg_writer.hpp"
+#include "scene_graph.hpp"
+
+// bytes buffered before the file is written to
+static const size_t BUFFER_SIZE = 1 << 20;
+
+// room left in the svg tag for the viewBox attribute
+static const size_t VIEWBOX_SPACE = 96;
+
+// the drawing is padded by the pen width so edges are not cut off
+static const Number PEN_WIDTH = 1;
+
+SvgWriter::SvgWriter(): buffer(BUFFER_SIZE), written(0)
+{
+}
+
+SvgWriter::~SvgWriter()
+{
+    if (out.is_open())
+    {
+        close();
+    }
+}
+
+bool SvgWriter::open(const std::string & file)
+{
+    if (out.is_open())
+    {
+        close();
+    }
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    out.open(file, std::ios::binary | std::ios::trunc);
+    if (!out.good())
+    {
+        return false;
+    }
+    bounds = Bounds();
+    written = 0;
+    shapes.clear();
+    shapeIds.clear();
+
+    //the canvas draws with a one unit black pen, points are filled
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" version=\"1.1\"";
+    viewBoxPosition = out.tellp();
+    out << std::string(VIEWBOX_SPACE, ' ') << ">\n";
+    out << "<g fill=\"none\" stroke=\"black\" stroke-width=\"" << PEN_WIDTH << "\">\n";
+    drawingPosition = out.tellp();
+    furthestPosition = drawingPosition;
+    return out.good();
+}
+
+void SvgWriter::addGraphic(const Atom & atom)
+{
+    if (writeAtom(atom))
+    {
+        bounds.include(atomBounds(atom));
+        written++;
+    }
+}
+
+//writes the element for an atom, false if it is not a graphic
+bool SvgWriter::writeAtom(const Atom & atom)
+{
+    if (atom.type == PointType)
+    {
+        //a 2x2 circle with its top left at the point
+        out << "<circle cx=\"";
+        number(atom.value.point_value.x + 1);
+        out << "\" cy=\"";
+        number(atom.value.point_value.y + 1);
+        out << "\" r=\"1\" fill=\"black\"/>\n";
+    }
+    else if (atom.type == LineType)
+    {
+        const Line & line = atom.value.line_value;
+        out << "<path d=\"M";
+        coordinate(line.first.x, line.first.y);
+        out << " L";
+        coordinate(line.second.x, line.second.y);
+        out << "\"/>\n";
+    }
+    else if (atom.type == ArcType)
+    {
+        const Arc & arc = atom.value.arc_value;
+        Number dx = arc.start.x - arc.center.x;
+        Number dy = arc.start.y - arc.center.y;
+        Number radius = std::sqrt(dx * dx + dy * dy);
+        //angles go counter clockwise on screen, y grows downward
+        const Number pi = std::atan2(0, -1);
+        Number start = std::atan2(-dy, dx);
+        Number span = std::max(-2 * pi, std::min(2 * pi, arc.span));
+        //positive spans turn the opposite way to SVG's sweep flag
+        const char * sweep = span > 0 ? " 0 " : " 1 ";
+
+        out << "<path d=\"M";
+        coordinate(arc.start.x, arc.start.y);
+        //an arc command cannot end where it starts, so a full circle is
+        //drawn as two halves
+        int pieces = std::fabs(span) >= 2 * pi ? 2 : 1;
+        for (int i = 1; i <= pieces; i++)
+        {
+            Number end = start + span * i / pieces;
+            out << " A";
+            number(radius);
+            out << " ";
+            number(radius);
+            out << " 0" << (std::fabs(span / pieces) > pi ? " 1" : " 0") << sweep;
+            coordinate(arc.center.x + radius * std::cos(end), arc.center.y - radius * std::sin(end));
+        }
+        out << "\"/>\n";
+    }
+    else if (atom.type == PolylineType || atom.type == PolygonType)
+    {
+        const PointList & vertices = atom.points();
+        out << "<path d=\"M";
+        coordinate(vertices[0].x, vertices[0].y);
+        for (size_t i = 1; i < vertices.size(); i++)
+        {
+            out << " L";
+            coordinate(vertices[i].x, vertices[i].y);
+        }
+        out << (atom.type == PolygonType ? " Z\"/>\n" : "\"/>\n");
+    }
+    else if (atom.type == GroupType)
+    {
+        //every instance of a shape uses the one definition of its strokes.
+        //the pen is one scene unit wide as on the canvas, so the use undoes
+        //the scale of its transform on the stroke width the shape inherits
+        const Instance & instance = atom.instance();
+        const Transform & t = instance.transform;
+        Number scale = std::sqrt(std::fabs(t.a * t.d - t.b * t.c));
+        if (scale > 0)
+        {
+            writeUse(defineShape(instance.group), t, scale);
+        }
+        writePoints(*instance.group, t);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+//writes a use of shape id through t, with the pen divided by scale
+void SvgWriter::writeUse(size_t id, const Transform & t, Number scale)
+{
+    out << "<use xlink:href=\"#shape" << id << "\" transform=\"matrix(";
+    number(t.a);
+    out << " ";
+    number(t.b);
+    out << " ";
+    number(t.c);
+    out << " ";
+    number(t.d);
+    out << " ";
+    number(t.e);
+    out << " ";
+    number(t.f);
+    out << ")\" stroke-width=\"";
+    number(PEN_WIDTH / scale);
+    out << "\"/>\n";
+}
+
+//writes the strokes of a shape into the defs the first time it is used.
+//a use inside a definition would scale the width it inherits a second
+//time, so the shapes it is made of are moved into it instead
+size_t SvgWriter::defineShape(const std::shared_ptr<const Group> & group)
+{
+    auto found = shapeIds.find(group.get());
+    if (found != shapeIds.end())
+    {
+        return found->second;
+    }
+    size_t id = shapes.size();
+    shapes.push_back(group);
+    shapeIds[group.get()] = id;
+    out << "<defs><g id=\"shape" << id << "\">\n";
+    writeStrokes(*group, identityTransform());
+    out << "</g></defs>\n";
+    return id;
+}
+
+//writes the lines, arcs and outlines of a shape moved by transform
+void SvgWriter::writeStrokes(const Group & group, const Transform & transform)
+{
+    for (size_t i = 0; i < group.children.size(); i++)
+    {
+        const Atom & child = group.children[i];
+        if (child.type == GroupType)
+        {
+            const Instance & instance = child.instance();
+            writeStrokes(*instance.group, composeTransforms(transform, instance.transform));
+        }
+        else if (child.type != PointType)
+        {
+            writeAtom(transformAtom(child, transform));
+        }
+    }
+}
+
+//writes the points of a shape where they are in the scene, a point keeps
+//its size in any instance as it does on the canvas
+void SvgWriter::writePoints(const Group & group, const Transform & transform)
+{
+    for (size_t i = 0; i < group.children.size(); i++)
+    {
+        const Atom & child = group.children[i];
+        if (child.type == GroupType)
+        {
+            const Instance & instance = child.instance();
+            writePoints(*instance.group, composeTransforms(transform, instance.transform));
+        }
+        else if (child.type == PointType)
+        {
+            writeAtom(transformAtom(child, transform));
+        }
+    }
+}
+
+void SvgWriter::addPolyline(const Polyline & points)
+{
+    if (points.size() < 2)
+    {
+        return;
+    }
+    out << "<path d=\"M";
+    coordinate(points[0].x, points[0].y);
+    bounds.include(points[0].x, points[0].y);
+    for (size_t i = 1; i < points.size(); i++)
+    {
+        out << " L";
+        coordinate(points[i].x, points[i].y);
+        bounds.include(points[i].x, points[i].y);
+    }
+    out << "\"/>\n";
+    written++;
+}
+
+bool SvgWriter::clearLayer(const std::string & name)
+{
+    if (!name.empty())
+    {
+        return false;
+    }
+    //later elements overwrite the old ones, close blanks out what is left
+    furthestPosition = std::max(furthestPosition, out.tellp());
+    out.seekp(drawingPosition);
+    bounds = Bounds();
+    written = 0;
+    shapes.clear();
+    shapeIds.clear();
+    return true;
+}
+
+bool SvgWriter::close()
+{
+    if (!out.is_open())
+    {
+        return false;
+    }
+    out << "</g>\n</svg>\n";
+    //whitespace after the root element is allowed
+    std::streampos end = out.tellp();
+    if (end < furthestPosition)
+    {
+        out << std::string(furthestPosition - end, ' ');
+    }
+
+    Bounds box = bounds;
+    if (box.empty())
+    {
+        box.include(0, 0);
+    }
+    char viewBox[VIEWBOX_SPACE + 1];
+    int length = std::snprintf(viewBox, sizeof(viewBox), " viewBox=\"%.10g %.10g %.10g %.10g\"",
+        box.left - PEN_WIDTH, box.top - PEN_WIDTH,
+        box.width() + 2 * PEN_WIDTH, box.height() + 2 * PEN_WIDTH);
+    out.seekp(viewBoxPosition);
+    out.write(viewBox, std::min<size_t>(length, VIEWBOX_SPACE));
+
+    bool ok = out.good();
+    out.close();
+    return ok && !out.fail();
+}
+
+size_t SvgWriter::count() const
+{
+    return written;
+}
+
+//ten significant digits is far more than can be seen
+void SvgWriter::number(Number value)
+{
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%.10g", value);
+    out.write(text, length);
+}
+
+void SvgWriter::coordinate(Number x, Number y)
+{
+    number(x);
+    out << ",";
+    number(y);
+}
+
+bool writeSvg(const std::string & file, const DisplayList & graphics)
+{
+    SvgWriter writer;
+    if (!writer.open(file))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        writer.addGraphic(graphics[i]);
+    }
+    return writer.close();
+}
+
+bool writeSvg(const std::string & file, const OptimizedDisplayList & optimized)
+{
+    SvgWriter writer;
+    if (!writer.open(file))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < optimized.graphics.size(); i++)
+    {
+        if (optimized.graphics[i].type != LineType)
+        {
+            writer.addGraphic(optimized.graphics[i]);
+        }
+    }
+    for (size_t i = 0; i < optimized.polylines.size(); i++)
+    {
+        writer.addPolyline(optimized.polylines[i]);
+    }
+    return writer.close();
+}
@@ -0,0 +1,81 @@
+#ifndef SVG_WRITER_HPP
+#define SVG_WRITER_HPP
+
+// system includes
+#include <map>
+#include <string>
+#include <memory>
+#include <vector>
+#include <fstream>
+
+// module includes
+#include "display_list.hpp"
+#include "graphics_sink.hpp"
+#include "display_list_optimizer.hpp"
+
+// SvgWriter streams atoms into an SVG file as they are drawn. Every atom
+// is written out through a buffer right away and only the running bounds
+// are kept, so memory use does not grow with the size of the drawing.
+// The viewBox is not known until the end, so room is left for it in the
+// svg tag and close seeks back to fill it in. (clear) rewinds to the start
+// of the drawing, but what is on one layer cannot be picked out of what
+// was already written, so (clear name) is an error.
+class SvgWriter: public GraphicsSink
+{
+public:
+
+  SvgWriter();
+  ~SvgWriter();
+
+  // start a new document, false if the file cannot be created
+  bool open(const std::string & file);
+
+  // write one point, line, arc, polyline, polygon or group, other atoms
+  // are ignored. the strokes of a group's shape are defined once and every
+  // instance of it refers to that definition, its points are written where
+  // they end up
+  void addGraphic(const Atom & atom);
+
+  // write a chain of segments as one path
+  void addPolyline(const Polyline & points);
+
+  // start the drawing over if name is empty, a single layer cannot be
+  // taken back out of a streamed document so false otherwise
+  bool clearLayer(const std::string & name);
+
+  // finish the document, false if anything could not be written
+  bool close();
+
+  // the number of atoms and polylines written so far
+  size_t count() const;
+
+private:
+
+  std::vector<char> buffer;
+  std::ofstream out;
+  std::streampos viewBoxPosition;
+  std::streampos drawingPosition;
+  std::streampos furthestPosition;
+  Bounds bounds;
+  size_t written;
+
+  //the shapes defined so far, kept alive so their addresses stay unique
+  std::vector<std::shared_ptr<const Group> > shapes;
+  std::map<const Group *, size_t> shapeIds;
+
+  bool writeAtom(const Atom & atom);
+  void writeUse(size_t id, const Transform & t, Number scale);
+  size_t defineShape(const std::shared_ptr<const Group> & group);
+  void writeStrokes(const Group & group, const Transform & transform);
+  void writePoints(const Group & group, const Transform & transform);
+  void number(Number value);
+  void coordinate(Number x, Number y);
+};
+
+// write a whole display list as an SVG file
+bool writeSvg(const std::string & file, const DisplayList & graphics);
+
+// write an optimized display list, its lines as the joined polylines
+bool writeSvg(const std::string & file, const OptimizedDisplayList & optimized);
+
+#endif
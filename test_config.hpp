@@ -5,6 +5,9 @@
 
 const std::string TEST_FILE_DIR = "/vagrant/tests";
 
+// where tests write the files they make, outside of the source tree
+const std::string TEST_OUTPUT_DIR = "/tmp";
+
 #endif
 
 
@@ -0,0 +1,60 @@
+#include "catch.hpp"
+
+#include <string>
+#include <sstream>
+
+#include "interpreter.hpp"
+#include "display_list.hpp"
+#include "test_helpers.hpp"
+
+TEST_CASE( "Test atom hashing", "[display list]" )
+{
+  DisplayList graphics = drawnBy("(draw (point 1 2) (point 1 2) (point 2 1) (line (point 1 2) (point 3 4)) "
+                                 "(arc (point 0 0) (point 1 0) pi) (arc (point 0 0) (point 1 0) (- pi)) (point 0 0))");
+  REQUIRE(graphics.size() == 7);
+
+  REQUIRE(sameGeometry(graphics[0], graphics[1]));
+  REQUIRE(hashAtom(graphics[0]) == hashAtom(graphics[1]));
+  REQUIRE_FALSE(sameGeometry(graphics[0], graphics[2]));
+  REQUIRE(hashAtom(graphics[0]) != hashAtom(graphics[2]));
+  REQUIRE_FALSE(sameGeometry(graphics[0], graphics[3]));
+  REQUIRE_FALSE(sameGeometry(graphics[4], graphics[5]));
+  REQUIRE(hashAtom(graphics[4]) != hashAtom(graphics[5]));
+
+  //negative zero is the same point as zero
+  Atom negative = graphics[6];
+  negative.value.point_value.x = -0.0;
+  REQUIRE(sameGeometry(negative, graphics[6]));
+  REQUIRE(hashAtom(negative) == hashAtom(graphics[6]));
+}
+
+TEST_CASE( "Test display list diff", "[display list]" )
+{
+  DisplayList before = drawnBy("(draw (point 1 1) (line (point 0 0) (point 5 5)) (point 1 1) (point 2 2))");
+  DisplayList after = drawnBy("(draw (line (point 0 0) (point 5 5)) (point 1 1) (point 3 3))");
+
+  DisplayListDiff diff = diffDisplayLists(before, after);
+  REQUIRE(diff.kept.size() == 3);
+  REQUIRE(diff.kept[0] == 1);
+  REQUIRE((diff.kept[1] == 0 || diff.kept[1] == 2));
+  REQUIRE(diff.kept[2] == DIFF_ADDED);
+
+  //one of the duplicate points and the moved point go
+  REQUIRE(diff.removed.size() == 2);
+  REQUIRE(diff.removed[1] == 3);
+  REQUIRE(diff.removed[0] == 2 - diff.kept[1]);
+
+  //nothing changed
+  DisplayListDiff same = diffDisplayLists(before, before);
+  REQUIRE(same.removed.empty());
+  for (size_t i = 0; i < before.size(); i++)
+  {
+    REQUIRE(same.kept[i] != DIFF_ADDED);
+    REQUIRE(sameGeometry(before[same.kept[i]], before[i]));
+  }
+
+  //everything changed
+  DisplayListDiff all = diffDisplayLists(before, DisplayList());
+  REQUIRE(all.kept.empty());
+  REQUIRE(all.removed.size() == before.size());
+}
@@ -6,8 +6,20 @@
 #include "main_window.hpp"
 #include "message_widget.hpp"
 #include "repl_widget.hpp"
+#include "qgraphics_arc_item.hpp"
+#include "qgraphics_instance_item.hpp"
+#include "graphics_items.hpp"
+#include "tiled_graphics_view.hpp"
+#include "offscreen_renderer.hpp"
+#include "sld_format.hpp"
+#include "file_watcher.hpp"
+#include "interpreter.hpp"
+#include "test_config.hpp"
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
 
 // ADD YOUR TESTS TO THIS CLASS !!!!!!!
 class TestGUI : public QObject {
@@ -23,12 +35,25 @@ private slots:
   void testPoint();
   void testLine();
   void testArc();
+  void testOutline();
+  void testInstances();
   void testEnvRestore();
   void testMessage();
   void cleanupTestCase();
   void testOutputs();
   void testUpAndDownArrows();
   void testClearMessage();
+  void testArcLevelOfDetail();
+  void testArcBounds();
+  void testTileCache();
+  void testOffscreenRender();
+  void testExportSvg();
+  void testRenderSld();
+  void testReloadFile();
+  void testWatchFile();
+  void testCancel();
+  void testProgressiveDrawing();
+  void testLayersAndUndo();
   
 private:
   MainWindow w;
@@ -83,7 +108,7 @@ void TestGUI::testREPLGood() {
   // check message
   QVERIFY2(messageEdit->isReadOnly(),
            "Expected QLineEdit inside MessageWidget to be read-only.");
-  QCOMPARE(messageEdit->text(), QString("(1)"));
+  QTRY_COMPARE(messageEdit->text(), QString("(1)"));
 }
 
 void TestGUI::testREPLBad() {
@@ -98,7 +123,7 @@ void TestGUI::testREPLBad() {
   // check message
   QVERIFY2(messageEdit->isReadOnly(),
            "Expected QLineEdit inside MessageWidget to be read-only.");
-  QVERIFY2(messageEdit->text().startsWith("Error"), "Expected error message.");
+  QTRY_VERIFY2(messageEdit->text().startsWith("Error"), "Expected error message.");
 
   // check background color and selection
   QPalette p = messageEdit->palette();
@@ -119,7 +144,7 @@ void TestGUI::testREPLBad2Good() {
   // check message
   QVERIFY2(messageEdit->isReadOnly(),
            "Expected QLineEdit inside MessageWidget to be read-only.");
-  QVERIFY2(messageEdit->text().startsWith("Error"), "Expected error message.");
+  QTRY_VERIFY2(messageEdit->text().startsWith("Error"), "Expected error message.");
 
   // check background color and selection
   QPalette p = messageEdit->palette();
@@ -134,7 +159,7 @@ void TestGUI::testREPLBad2Good() {
   // check message
   QVERIFY2(messageEdit->isReadOnly(),
            "Expected QLineEdit inside MessageWidget to be read-only.");
-  QCOMPARE(messageEdit->text(), QString("(100)"));
+  QTRY_COMPARE(messageEdit->text(), QString("(100)"));
 
   // check background color and selection
   p = messageEdit->palette();
@@ -154,7 +179,7 @@ void TestGUI::testPoint() {
   QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
 
   // check canvas
-  QVERIFY2(scene->itemAt(QPointF(0, 0), QTransform()) != 0,
+  QTRY_VERIFY2(scene->itemAt(QPointF(0, 0), QTransform()) != 0,
            "Expected a point in the scene. Not found.");
 }
 
@@ -168,9 +193,9 @@ void TestGUI::testLine() {
   QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
   
   // check canvas
-  QVERIFY2(scene->itemAt(QPointF(10, 0), QTransform()) != 0,
+  QTRY_VERIFY2(scene->itemAt(QPointF(10, 0), QTransform()) != 0,
            "Expected a line in the scene. Not found.");
-  QVERIFY2(scene->itemAt(QPointF(0, 10), QTransform()) != 0,
+  QTRY_VERIFY2(scene->itemAt(QPointF(0, 10), QTransform()) != 0,
            "Expected a line in the scene. Not found.");
 }
 
@@ -184,16 +209,75 @@ void TestGUI::testArc() {
   QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
 
   // check canvas
-  QVERIFY2(scene->itemAt(QPointF(100, 0), QTransform()) != 0,
+  QTRY_VERIFY2(scene->itemAt(QPointF(100, 0), QTransform()) != 0,
            "Expected a point on the arc in the scene. Not found.");
-  QVERIFY2(scene->itemAt(QPointF(-100, 0), QTransform()) != 0,
+  QTRY_VERIFY2(scene->itemAt(QPointF(-100, 0), QTransform()) != 0,
            "Expected a point on the arc in the scene. Not found.");
 
-  QGraphicsItem * temp = scene->itemAt(QPointF(-20, -1), QTransform());
+  //only the curve is hit, not the inside of the half circle
+  QVERIFY(scene->itemAt(QPointF(-20, -50), QTransform()) == 0);
+  QGraphicsItem * temp = scene->itemAt(QPointF(0, -100), QTransform());
+  QVERIFY(temp);
   qDebug() << temp;
   qDebug() << temp->boundingRect();
 }
 
+void TestGUI::testOutline()
+{
+    QtInterpreter interp;
+    CanvasWidget canvas;
+    QGraphicsScene * scene = canvas.findChild<QGraphicsScene *>();
+    QVERIFY(scene);
+    canvas.drainFrom(interp.itemQueue());
+
+    //a thousand vertices are one item
+    interp.parseAndEvaluate("(begin (define angles (linspace 0 (* 2 pi) 1000)) "
+                            "(polygon (* 100 (cos angles)) (* 100 (sin angles))))");
+    QTRY_COMPARE(scene->items().size(), 1);
+    QVERIFY(qgraphicsitem_cast<QGraphicsPathItem *>(scene->items().front()));
+    QVERIFY(scene->itemAt(QPointF(100, 0), QTransform()) != 0);
+    QVERIFY(scene->itemAt(QPointF(0, -100), QTransform()) != 0);
+}
+
+void TestGUI::testInstances()
+{
+    QtInterpreter interp;
+    CanvasWidget canvas;
+    QGraphicsScene * scene = canvas.findChild<QGraphicsScene *>();
+    QVERIFY(scene);
+    canvas.drainFrom(interp.itemQueue());
+
+    //every instance is an item placed by its transform
+    interp.parseAndEvaluate("(begin (define tick (group (line (point 0 0) (point 0 10)))) "
+                            "(for i 0 100 1 (draw (translate (* 20 i) 0 tick))))");
+    QTRY_COMPARE(scene->items().size(), 100);
+    QGraphicsItem * item = scene->itemAt(QPointF(40, 5), QTransform());
+    QVERIFY(dynamic_cast<QGraphicsInstanceItem *>(item));
+    QCOMPARE(item->transform().dx(), 40.0);
+    QVERIFY(scene->itemAt(QPointF(50, 5), QTransform()) == 0);
+
+    //a scaled instance is stroked with the same pen as a line drawn where
+    //it ends up, shown here at twice its size
+    std::istringstream iss("(draw (scale 10 (group (line (point 0 0) (point 1 2)))) (line (point 0 0) (point 10 20)))");
+    Interpreter drawing;
+    QVERIFY(drawing.parse(iss));
+    drawing.eval();
+    drawing.setGraphics();
+    std::vector<Atom> atoms = drawing.getGraphics();
+    QCOMPARE(atoms.size(), size_t(2));
+    QImage images[2];
+    for (int i = 0; i < 2; i++)
+    {
+        QGraphicsScene alone;
+        alone.addItem(makeGraphicsItem(atoms[i]));
+        images[i] = QImage(64, 64, QImage::Format_ARGB32);
+        images[i].fill(Qt::white);
+        QPainter painter(&images[i]);
+        alone.render(&painter, QRectF(0, 0, 64, 64), QRectF(-2, -2, 32, 32));
+    }
+    QCOMPARE(images[0], images[1]);
+}
+
 void TestGUI::testEnvRestore() {
   
   QVERIFY(repl && replEdit);
@@ -206,6 +290,9 @@ void TestGUI::testEnvRestore() {
   QTest::keyClicks(replEdit, "(begin (draw (point -20 0)) (define pi 3))");
   QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
 
+  // wait for the evaluation to fail
+  QTRY_VERIFY(messageEdit->text().startsWith("Error"));
+
   // check canvas
   QGraphicsItem * temp = scene->itemAt(QPointF(-20, 0), QTransform());
   qDebug() << temp;
@@ -242,47 +329,47 @@ void TestGUI::testOutputs()
     QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
     // check message
     QVERIFY2(messageEdit->isReadOnly(), "Expected QLineEdit inside MessageWidget to be read-only.");
-    QCOMPARE(messageEdit->text(), QString("(True)"));
+    QTRY_COMPARE(messageEdit->text(), QString("(True)"));
     // send a string to the repl widget
     QTest::keyClicks(replEdit, "(False)");
     QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
     // check message
     QVERIFY2(messageEdit->isReadOnly(), "Expected QLineEdit inside MessageWidget to be read-only.");
-    QCOMPARE(messageEdit->text(), QString("(False)"));
+    QTRY_COMPARE(messageEdit->text(), QString("(False)"));
     // send a string to the repl widget
     QTest::keyClicks(replEdit, "(point 1 1)");
     QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
     // check message
     QVERIFY2(messageEdit->isReadOnly(), "Expected QLineEdit inside MessageWidget to be read-only.");
-    QCOMPARE(messageEdit->text(), QString("(1,1)"));
+    QTRY_COMPARE(messageEdit->text(), QString("(1,1)"));
     // send a string to the repl widget
     QTest::keyClicks(replEdit, "(line (point 1 1) (point 2 2))");
     QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
     // check message
     QVERIFY2(messageEdit->isReadOnly(), "Expected QLineEdit inside MessageWidget to be read-only.");
-    QCOMPARE(messageEdit->text(), QString("((1,1),(2,2))"));
+    QTRY_COMPARE(messageEdit->text(), QString("((1,1),(2,2))"));
     // send a string to the repl widget
     QTest::keyClicks(replEdit, "(arc (point 1 1) (point 2 2) 3.14)");
     QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
     // check message
     QVERIFY2(messageEdit->isReadOnly(), "Expected QLineEdit inside MessageWidget to be read-only.");
-    QCOMPARE(messageEdit->text(), QString("((1,1),(2,2) 3.14)"));
+    QTRY_COMPARE(messageEdit->text(), QString("((1,1),(2,2) 3.14)"));
     // send a string to the repl widget
     QTest::keyClicks(replEdit, "(1)");
     QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
     // check message
     QVERIFY2(messageEdit->isReadOnly(), "Expected QLineEdit inside MessageWidget to be read-only.");
-    QCOMPARE(messageEdit->text(), QString("(1)"));
+    QTRY_COMPARE(messageEdit->text(), QString("(1)"));
     // send a string to the repl widget
     QTest::keyClicks(replEdit, "(+ 1 3");
     QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
     // check message
     QVERIFY2(messageEdit->isReadOnly(), "Expected QLineEdit inside MessageWidget to be read-only.");
+    QTRY_COMPARE(messageEdit->text(), QString("Error: Cannot Parse"));
     // check background color and selection
     QPalette p = messageEdit->palette();
     QVERIFY2(p.highlight().color() == QColor(Qt::red),
            "expected red highlight on unsuccessful eval.");
-    QCOMPARE(messageEdit->text(), QString("Error: Cannot Parse"));
 
 }
 
@@ -317,11 +404,456 @@ void TestGUI::testClearMessage()
 
     // check message
     QVERIFY2(messageEdit->isReadOnly(), "Expected QLineEdit inside MessageWidget to be read-only.");
-    QCOMPARE(messageEdit->text(), QString("(1,1)"));
+    QTRY_COMPARE(messageEdit->text(), QString("(1,1)"));
 
     message->clear();
     QCOMPARE(messageEdit->text(), QString(""));
 }
 
+void TestGUI::testArcLevelOfDetail()
+{
+    QGraphicsScene arcScene;
+    QGraphicsArcItem * arc = new QGraphicsArcItem(0, 0, 200, 200);
+    arc->setRect(QRectF(-100, -100, 200, 200));
+    arc->setStartAngle(0);
+    arc->setSpanAngle(180 * 16);
+    arcScene.addItem(arc);
+
+    //zoomed in far enough that the arc is tessellated
+    QImage image(100, 100, QImage::Format_ARGB32);
+    image.fill(Qt::white);
+    QPainter painter(&image);
+    arcScene.render(&painter, QRectF(0, 0, 100, 100), QRectF(-100, -100, 200, 200));
+    painter.end();
+    int top = 0;
+    int bottom = 0;
+    for (int y = 0; y < 100; y++)
+    {
+        for (int x = 0; x < 100; x++)
+        {
+            if (image.pixelColor(x, y) != QColor(Qt::white) && y < 45)
+            {
+                top++;
+            }
+            else if (image.pixelColor(x, y) != QColor(Qt::white) && y > 55)
+            {
+                bottom++;
+            }
+        }
+    }
+    QVERIFY2(top > 0, "Expected the top half of the arc to be drawn.");
+    QCOMPARE(bottom, 0);
+
+    //zoomed out so far that the arc is a single dot
+    QImage speck(10, 10, QImage::Format_ARGB32);
+    speck.fill(Qt::white);
+    QPainter speckPainter(&speck);
+    speckPainter.translate(5, 5);
+    speckPainter.scale(0.001, 0.001);
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = arc->boundingRect();
+    arc->paint(&speckPainter, &option, nullptr);
+    speckPainter.end();
+    QVERIFY2(speck.pixelColor(5, 5) != QColor(Qt::white), "Expected the arc to be drawn as a dot.");
+
+    //at the top of a bucket, where the scale is largest, no chord is more
+    //than a quarter pixel inside the curve
+    for (int bucket = -3; bucket <= 8; bucket++)
+    {
+        qreal lod = std::pow(2.0, (bucket + 1) / 2.0) * 0.999;
+        QCOMPARE(arc->zoomBucket(lod), bucket);
+        const QPolygonF & polygon = arc->tessellation(bucket);
+        qreal worst = 0;
+        for (int i = 1; i < polygon.size(); i++)
+        {
+            QPointF middle = (polygon[i - 1] + polygon[i]) / 2;
+            worst = qMax(worst, 100 - std::hypot(middle.x(), middle.y()));
+        }
+        QVERIFY(worst * lod <= 0.25);
+    }
+}
+
+void TestGUI::testArcBounds()
+{
+    //the constructor takes the ellipse like QGraphicsEllipseItem does
+    QGraphicsArcItem arc(-1000, -1000, 2000, 2000);
+    QCOMPARE(arc.rect(), QRectF(-1000, -1000, 2000, 2000));
+
+    //a sliver of a huge circle is bounded by the sliver, padded by half
+    //the pen, and shaped like the curve
+    arc.setStartAngle(0);
+    arc.setSpanAngle(16);
+    QRectF bounds = arc.boundingRect();
+    QVERIFY(bounds.contains(QPointF(1000, 0)));
+    QVERIFY(bounds.width() < 2);
+    QVERIFY(bounds.height() < 20);
+    QVERIFY(bounds.top() < -17 && bounds.bottom() >= 0.5);
+    QVERIFY(arc.shape().contains(QPointF(999.9, -10)));
+    QVERIFY(!arc.shape().contains(QPointF(990, -10)));
+    QVERIFY(!arc.contains(QPointF(0, 0)));
+
+    //crossing an axis takes in the extreme point, the bounds follow changes
+    arc.setStartAngle(80 * 16);
+    arc.setSpanAngle(20 * 16);
+    bounds = arc.boundingRect();
+    QCOMPARE(bounds.top(), -1000.5);
+    QVERIFY(bounds.bottom() < -980);
+    QVERIFY(qAbs(bounds.left() + 1000 * std::sin(qDegreesToRadians(10.0)) + 0.5) < 1e-6);
+
+    //a clockwise turn goes below the center
+    arc.setSpanAngle(-180 * 16);
+    QCOMPARE(arc.boundingRect().bottom(), 1000.5);
+
+    arc.setSpanAngle(360 * 16);
+    QCOMPARE(arc.boundingRect(), QRectF(-1000.5, -1000.5, 2001, 2001));
+    QVERIFY(!arc.contains(QPointF(0, 0)));
+}
+
+void TestGUI::testTileCache()
+{
+    TiledGraphicsView * view = canvas->findChild<TiledGraphicsView *>();
+    QVERIFY2(view, "Could not find TiledGraphicsView instance in CanvasWidget instance.");
+
+    //painting the view fills the cache
+    view->viewport()->repaint();
+    int cached = view->cachedTiles();
+    QVERIFY2(cached > 0, "Expected tiles to be cached after a repaint.");
+
+    //a new primitive only drops the tiles it lands on
+    QTest::keyClicks(replEdit, "(draw (point 5 5))");
+    QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
+    QCoreApplication::processEvents();
+    QVERIFY(view->cachedTiles() < cached);
+
+    //zooming renders tiles for the new level next to the old ones
+    view->zoom(-1);
+    view->viewport()->repaint();
+    QVERIFY(view->cachedTiles() > 0);
+    view->zoom(1);
+}
+
+void TestGUI::testOffscreenRender()
+{
+    QImage image;
+    std::string error;
+    QVERIFY(renderScript(TEST_FILE_DIR + "/test_car.slp", QSize(200, 100), image, error));
+    QCOMPARE(image.size(), QSize(200, 100));
+
+    //something of the car was drawn
+    int drawn = 0;
+    for (int y = 0; y < image.height(); y++)
+    {
+        for (int x = 0; x < image.width(); x++)
+        {
+            if (image.pixelColor(x, y) != QColor(Qt::white))
+            {
+                drawn++;
+            }
+        }
+    }
+    QVERIFY2(drawn > 0, "Expected the car to be drawn.");
+
+    //errors are reported, not drawn
+    QVERIFY(!renderScript(TEST_FILE_DIR + "/test_badparse.slp", QSize(200, 100), image, error));
+    QCOMPARE(QString::fromStdString(error), QString("Error: Cannot Parse"));
+    QVERIFY(!renderScript(TEST_FILE_DIR + "/test_badeval.slp", QSize(200, 100), image, error));
+    QVERIFY(!renderScript(TEST_FILE_DIR + "/missing.slp", QSize(200, 100), image, error));
+}
+
+void TestGUI::testExportSvg()
+{
+    QtInterpreter interp;
+    interp.parseAndEvaluate("(draw (line (point 0 0) (point 20 10)) (arc (point 0 0) (point 5 0) pi))");
+
+    QTemporaryDir dir;
+    QString file = dir.path() + "/export.svg";
+    QSignalSpy errors(&interp, &QtInterpreter::error);
+    interp.exportSvg(file);
+    QCOMPARE(errors.count(), 0);
+
+    QFile svg(file);
+    QVERIFY(svg.open(QIODevice::ReadOnly));
+    QString text = svg.readAll();
+    QVERIFY(text.contains("<svg"));
+    QVERIFY(text.contains("<path d=\"M0,0 L20,10\"/>"));
+    QVERIFY(text.contains(" A5 5 0 0 0 "));
+    QVERIFY(text.trimmed().endsWith("</svg>"));
+
+    //a bad path is reported
+    interp.exportSvg(dir.path() + "/missing/export.svg");
+    QCOMPARE(errors.count(), 1);
+}
+
+void TestGUI::testRenderSld()
+{
+    std::ifstream ifs(TEST_FILE_DIR + "/test_car.slp");
+    Interpreter interp;
+    QVERIFY(interp.parse(ifs));
+    interp.eval();
+    interp.setGraphics();
+
+    QTemporaryDir dir;
+    std::string sld = dir.path().toStdString() + "/car.sld";
+    QVERIFY(writeSld(sld, interp.getGraphics()));
+
+    //the saved geometry renders like running the script, only the order
+    //of overlapping antialiased edges can differ
+    QImage fromScript, fromSld;
+    std::string error;
+    QVERIFY(renderScript(TEST_FILE_DIR + "/test_car.slp", QSize(200, 100), fromScript, error));
+    QVERIFY(renderScript(sld, QSize(200, 100), fromSld, error));
+    QCOMPARE(fromSld.size(), fromScript.size());
+    int different = 0;
+    for (int y = 0; y < fromSld.height(); y++)
+    {
+        for (int x = 0; x < fromSld.width(); x++)
+        {
+            if (qAbs(qRed(fromSld.pixel(x, y)) - qRed(fromScript.pixel(x, y))) > 8)
+            {
+                different++;
+            }
+        }
+    }
+    QVERIFY(different < 20);
+
+    QVERIFY(!renderScript(TEST_FILE_DIR + "/test_car.slp.sld", QSize(200, 100), fromSld, error));
+}
+
+void TestGUI::testReloadFile()
+{
+    QtInterpreter interp;
+    CanvasWidget canvas;
+    QGraphicsScene * scene = canvas.findChild<QGraphicsScene *>();
+    QVERIFY(scene);
+    connect(&interp, &QtInterpreter::drawGraphic, &canvas, &CanvasWidget::addGraphic);
+    connect(&interp, &QtInterpreter::removeGraphics, &canvas, &CanvasWidget::removeGraphics);
+    canvas.drainFrom(interp.itemQueue());
+
+    QTemporaryDir dir;
+    QString file = dir.path() + "/reload.slp";
+    auto write = [&file](const char * program)
+    {
+        QFile slp(file);
+        slp.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        slp.write(program);
+    };
+
+    write("(draw (point 0 0) (line (point 10 0) (point 20 0)) (arc (point 0 0) (point 5 0) pi))");
+    interp.parseAndEvaluate(file);
+    QTRY_COMPARE(scene->items().size(), 3);
+    QGraphicsItem * line = scene->itemAt(QPointF(15, 0), QTransform());
+    QVERIFY(line);
+
+    //entering it again without changes touches nothing
+    interp.parseAndEvaluate(file);
+    QCOMPARE(scene->items().size(), 3);
+    QCOMPARE(scene->itemAt(QPointF(15, 0), QTransform()), line);
+
+    //only the moved point is replaced, the line item is the same one
+    write("(draw (point 30 30) (line (point 10 0) (point 20 0)) (arc (point 0 0) (point 5 0) pi))");
+    interp.parseAndEvaluate(file);
+    QCOMPARE(scene->items().size(), 3);
+    QCOMPARE(scene->itemAt(QPointF(15, 0), QTransform()), line);
+    QVERIFY(scene->itemAt(QPointF(0.5, 0.5), QTransform()) == 0);
+    QVERIFY(scene->itemAt(QPointF(30.5, 30.5), QTransform()) != 0);
+
+    //what the REPL draws stays
+    interp.parseAndEvaluate("(draw (point 50 50))");
+    write("(draw (point 30 30))");
+    interp.parseAndEvaluate(file);
+    QCOMPARE(scene->items().size(), 2);
+}
+
+void TestGUI::testWatchFile()
+{
+    QTemporaryDir dir;
+    QString file = dir.path() + "/watch.slp";
+    auto write = [&file](const char * program)
+    {
+        QFile slp(file);
+        slp.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        slp.write(program);
+    };
+    write("(draw (point 0 0) (line (point 10 0) (point 20 0)))");
+
+    QtInterpreter interp;
+    CanvasWidget canvas;
+    QGraphicsScene * scene = canvas.findChild<QGraphicsScene *>();
+    QVERIFY(scene);
+    connect(&interp, &QtInterpreter::drawGraphic, &canvas, &CanvasWidget::addGraphic);
+    connect(&interp, &QtInterpreter::removeGraphics, &canvas, &CanvasWidget::removeGraphics);
+    FileWatcher watcher(file);
+    QSignalSpy failures(&watcher, &FileWatcher::failed);
+    connect(&watcher, &FileWatcher::evaluated, &interp, &QtInterpreter::showDrawing);
+
+    //the first evaluation happens without a save
+    QTRY_COMPARE(scene->items().size(), 2);
+    QGraphicsItem * line = scene->itemAt(QPointF(15, 0), QTransform());
+    QVERIFY(line);
+
+    //a burst of saves ends up as the last version, the line is kept
+    write("(draw (point 5 5) (line (point 10 0) (point 20 0)))");
+    write("(draw (point 6 6) (line (point 10 0) (point 20 0)))");
+    write("(draw (point 7 7) (line (point 10 0) (point 20 0)) (point 30 30))");
+    QTRY_COMPARE(scene->items().size(), 3);
+    QTRY_VERIFY(scene->itemAt(QPointF(30.5, 30.5), QTransform()) != 0);
+    QCOMPARE(scene->itemAt(QPointF(15, 0), QTransform()), line);
+    QVERIFY(scene->itemAt(QPointF(0.5, 0.5), QTransform()) == 0);
+
+    //errors leave the drawing alone
+    write("(draw (point 0 0)");
+    QTRY_COMPARE(failures.count(), 1);
+    QCOMPARE(scene->items().size(), 3);
+
+    //a watcher goes away without waiting for a slow script to finish
+    QString slow = dir.path() + "/slow.slp";
+    {
+        QFile slp(slow);
+        QVERIFY(slp.open(QIODevice::WriteOnly));
+        slp.write("(for i 0 1000000000 1 (+ i 1))");
+    }
+    QElapsedTimer timer;
+    timer.start();
+    {
+        FileWatcher slowWatcher(slow);
+        QTest::qWait(50);
+    }
+    QVERIFY(timer.elapsed() < 2000);
+}
+
+void TestGUI::testCancel()
+{
+    QLabel * label = repl->findChild<QLabel *>();
+    QVERIFY(label);
+    QCOMPARE(label->text(), QString("slisp>"));
+
+    //a script that takes a long time to run
+    QTemporaryDir dir;
+    QString file = dir.path() + "/slow.slp";
+    {
+        QFile slp(file);
+        QVERIFY(slp.open(QIODevice::WriteOnly));
+        slp.write("(begin (define slow 0)");
+        for (int i = 0; i < 200000; i++)
+        {
+            slp.write(" (define slow (+ slow 1))");
+        }
+        slp.write(" (draw (point 500 500)))");
+    }
+
+    //the window keeps working while it runs
+    QTest::keyClicks(replEdit, file);
+    QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
+    QTRY_COMPARE(label->text(), QString("running") + QChar(0x2026));
+    QCOMPARE(replEdit->text(), QString(""));
+
+    //escape stops it, nothing it drew is shown
+    QTest::keyClick(replEdit, Qt::Key_Escape, Qt::NoModifier);
+    QTRY_COMPARE_WITH_TIMEOUT(messageEdit->text(), QString("Error: evaluation cancelled"), 30000);
+    QTRY_COMPARE(label->text(), QString("slisp>"));
+    QVERIFY(scene->itemAt(QPointF(500.5, 500.5), QTransform()) == 0);
+
+    //and the next entry runs as usual
+    QTest::keyClicks(replEdit, "(+ 1 2)");
+    QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
+    QTRY_COMPARE(messageEdit->text(), QString("(3)"));
+}
+
+void TestGUI::testProgressiveDrawing()
+{
+    QThread thread;
+    QtInterpreter interp;
+    CanvasWidget canvas;
+    QGraphicsScene * scene = canvas.findChild<QGraphicsScene *>();
+    QVERIFY(scene);
+    interp.moveToThread(&thread);
+    connect(&interp, &QtInterpreter::removeGraphics, &canvas, &CanvasWidget::removeGraphics);
+    canvas.drainFrom(interp.itemQueue());
+    int failures = 0;
+    connect(&interp, &QtInterpreter::error, &canvas, [&failures] { failures++; });
+    thread.start();
+
+    //more points than the queue holds, the evaluation only gets through
+    //them because the canvas takes them while it runs
+    QString program = "(begin";
+    for (int i = 0; i < 20000; i++)
+    {
+        program += QString(" (draw (point %1 0))").arg(i);
+    }
+    program += ")";
+    QVERIFY(interp.itemQueue()->capacity() < 20000);
+    QMetaObject::invokeMethod(&interp, "parseAndEvaluate", Qt::QueuedConnection, Q_ARG(QString, program));
+    QTRY_COMPARE_WITH_TIMEOUT(scene->items().size(), 20000, 30000);
+
+    //a failed evaluation takes back what it already queued, the removals
+    //arrive before the error
+    program = program.left(program.size() - 1) + " (undefined-procedure))";
+    QMetaObject::invokeMethod(&interp, "parseAndEvaluate", Qt::QueuedConnection, Q_ARG(QString, program));
+    QTRY_COMPARE_WITH_TIMEOUT(failures, 1, 30000);
+    QCOMPARE(scene->items().size(), 20000);
+    QVERIFY(interp.itemQueue()->empty());
+
+    thread.quit();
+    thread.wait();
+}
+
+void TestGUI::testLayersAndUndo()
+{
+    QtInterpreter interp;
+    CanvasWidget canvas;
+    QGraphicsScene * scene = canvas.findChild<QGraphicsScene *>();
+    QVERIFY(scene);
+    connect(&interp, &QtInterpreter::drawGraphic, &canvas, &CanvasWidget::addGraphic);
+    connect(&interp, &QtInterpreter::removeGraphics, &canvas, &CanvasWidget::removeGraphics);
+    canvas.drainFrom(interp.itemQueue());
+    QSignalSpy errors(&interp, &QtInterpreter::error);
+
+    interp.parseAndEvaluate("(draw (point 0 0) (point 10 0))");
+    interp.parseAndEvaluate("(begin (layer top) (draw (point 20 0)))");
+    QTRY_COMPARE(scene->items().size(), 3);
+
+    //clearing a layer leaves the others
+    interp.parseAndEvaluate("(clear main)");
+    QCOMPARE(scene->items().size(), 1);
+    QVERIFY(scene->itemAt(QPointF(20.5, 0.5), QTransform()) != 0);
+
+    //undo brings back what was cleared, then takes back what was drawn
+    interp.undo();
+    QCOMPARE(scene->items().size(), 3);
+    QVERIFY(scene->itemAt(QPointF(10.5, 0.5), QTransform()) != 0);
+    interp.undo();
+    QCOMPARE(scene->items().size(), 2);
+    QVERIFY(scene->itemAt(QPointF(20.5, 0.5), QTransform()) == 0);
+
+    interp.parseAndEvaluate("(clear)");
+    QCOMPARE(scene->items().size(), 0);
+    interp.undo();
+    QCOMPARE(scene->items().size(), 2);
+    interp.undo();
+    QCOMPARE(scene->items().size(), 0);
+    QCOMPARE(errors.count(), 0);
+    interp.undo();
+    QCOMPARE(errors.count(), 1);
+
+    //over the limit the history goes, then the oldest layers, but never
+    //what the last entry drew
+    interp.parseAndEvaluate("(begin (layer a) (draw (point 0 0) (point 1 1)))");
+    interp.parseAndEvaluate("(begin (layer b) (draw (point 30 30)))");
+    QTRY_COMPARE(scene->items().size(), 3);
+    qint64 used = interp.memoryUsage();
+    interp.setMemoryLimit(1);
+    QCOMPARE(scene->items().size(), 1);
+    QVERIFY(scene->itemAt(QPointF(30.5, 30.5), QTransform()) != 0);
+    QVERIFY(interp.memoryUsage() > 0);
+    QVERIFY(interp.memoryUsage() < used);
+    interp.undo();
+    QCOMPARE(errors.count(), 2);
+
+    //a limit the drawing fits in keeps everything
+    interp.setMemoryLimit(used);
+    interp.parseAndEvaluate("(draw (point 40 40))");
+    QTRY_COMPARE(scene->items().size(), 2);
+}
+
 QTEST_MAIN(TestGUI)
 #include "test_gui.moc"
@@ -0,0 +1,49 @@
+#ifndef TEST_HELPERS_HPP
+#define TEST_HELPERS_HPP
+
+// helpers shared by the unit tests, include after catch.hpp
+
+// system includes
+#include <string>
+#include <sstream>
+#include <fstream>
+
+// module includes
+#include "interpreter.hpp"
+#include "display_list.hpp"
+
+// what a program draws, it has to parse and run without an error
+inline DisplayList drawnBy(const std::string & program)
+{
+  std::istringstream iss(program);
+  Interpreter interp;
+  REQUIRE(interp.parse(iss));
+  REQUIRE_NOTHROW(interp.eval());
+  interp.setGraphics();
+  return interp.getGraphics();
+}
+
+// what the program in a file draws
+inline DisplayList drawnByFile(const std::string & fname)
+{
+  std::ifstream ifs(fname);
+  REQUIRE(ifs.good() == true);
+  Interpreter interp;
+  REQUIRE(interp.parse(ifs));
+  REQUIRE_NOTHROW(interp.eval());
+  interp.setGraphics();
+  return interp.getGraphics();
+}
+
+// how many times what occurs in text, overlaps included
+inline size_t countOf(const std::string & text, const std::string & what)
+{
+  size_t count = 0;
+  for (size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1))
+  {
+    count++;
+  }
+  return count;
+}
+
+#endif
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <atomic>
 
 #include "interpreter_semantic_error.hpp"
 #include "interpreter.hpp"
@@ -397,9 +398,45 @@ TEST_CASE( "Test logical procedures", "[interpreter]" )
   REQUIRE(run("(or True True False)") == Expression(true));
 }
 
+TEST_CASE( "Test and/or short-circuit", "[interpreter]" )
+{
+  REQUIRE(run("(and)") == Expression(true));
+  REQUIRE(run("(or)") == Expression(false));
+
+  //nothing after the deciding operand is evaluated, not even to check it
+  REQUIRE(run("(and False 12 (/ 1 0) (begin nowhere))") == Expression(false));
+  REQUIRE(run("(or True 12 (/ 1 0) (begin nowhere))") == Expression(true));
+  REQUIRE(run("(and True (or False (< 1 2)) (not False))") == Expression(true));
+
+  //an operand that is reached is still checked
+  Interpreter invalid;
+  std::istringstream unknown("(and True (begin nowhere) False)");
+  REQUIRE(invalid.parse(unknown));
+  REQUIRE_THROWS_AS(invalid.eval(), InterpreterSemanticError);
+
+  //operands are evaluated left to right and a skipped one draws nothing
+  Interpreter interp;
+  std::istringstream iss("(begin "
+                         "(or (begin (draw (point 1 0)) False) (begin (draw (point 2 0)) True) (begin (draw (point 3 0)) True)) "
+                         "(and (begin (define x 5) True) (< x 1) (begin (draw (point 4 0)) True)) x)");
+  REQUIRE(interp.parse(iss));
+  Expression result;
+  REQUIRE_NOTHROW(result = interp.eval());
+  REQUIRE(result == Expression(5.));
+  interp.setGraphics();
+  std::vector<Atom> graphics = interp.getGraphics();
+  REQUIRE(graphics.size() == 2);
+  REQUIRE(graphics[0].value.point_value.x == 1);
+  REQUIRE(graphics[1].value.point_value.x == 2);
+}
+
 TEST_CASE( "Test trig procedures", "[interpreter]" ) {
 
   REQUIRE(run("(sin pi)") == Expression(0.));
+  //only a sine too small to tell from 0 is taken as 0, a negative one is kept
+  REQUIRE(run("(sin (- 0 (/ pi 2)))") == Expression(-1.));
+  REQUIRE(run("(sin (- 0 0.5))") == Expression(sin(-0.5)));
+  REQUIRE(run("(sin 0.0001)") == Expression(0.));
   REQUIRE(run("(cos pi)") == Expression(-1.));
   REQUIRE(run("(arctan 1 0)") == Expression(atan2(1,0)));
 
@@ -742,7 +779,7 @@ TEST_CASE( "Test invalid and", "[interpreter]" )
 TEST_CASE( "Test invalid or", "[interpreter]" ) 
 {
 
-    std::string program = "(or True 12 sup)";
+    std::string program = "(or False 12 sup)";
     Interpreter interp;
     std::istringstream iss(program);
     bool ok = interp.parse(iss);
@@ -1104,3 +1141,412 @@ TEST_CASE( "Test  invalid point/line/arc", "[interpreter]" )
 
 
 
+
+TEST_CASE( "Test cancelled evaluation", "[interpreter]" )
+{
+  std::string program = "(begin (define a 1) (define b (+ a 1)))";
+  std::atomic<bool> cancel(false);
+  Interpreter interp;
+  interp.setCancelFlag(&cancel);
+
+  std::istringstream iss(program);
+  REQUIRE(interp.parse(iss));
+  REQUIRE(interp.eval() == Expression(2.));
+
+  //once the flag is set nothing more is evaluated
+  cancel = true;
+  std::istringstream iss2(program);
+  REQUIRE(interp.parse(iss2));
+  REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+
+  cancel = false;
+  std::istringstream iss3("(+ b 1)");
+  REQUIRE(interp.parse(iss3));
+  REQUIRE(interp.eval() == Expression(3.));
+}
+
+TEST_CASE( "Test layers and clear", "[interpreter]" )
+{
+  Interpreter interp;
+  auto eval = [&interp](const std::string & program)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    interp.eval();
+    interp.setGraphics();
+    return interp.getGraphics();
+  };
+
+  //draw goes on main until another layer is picked
+  REQUIRE(eval("(begin (draw (point 0 0)) (layer top) (draw (point 1 1) (point 2 2)))").size() == 3);
+  REQUIRE(eval("(begin (draw (point 3 3)) (clear main))").size() == 3);
+  std::vector<Atom> graphics = eval("(clear nothing)");
+  REQUIRE(graphics.size() == 3);
+  REQUIRE(graphics[0].value.point_value.x == 1);
+  REQUIRE(graphics[2].value.point_value.x == 3);
+
+  //the layer stays picked between entries
+  REQUIRE(eval("(begin (clear top) (draw (point 4 4)))").size() == 1);
+  REQUIRE(eval("(begin (layer main) (draw (point 5 5)) (clear))").empty());
+
+  std::vector<std::string> bad = {"(layer)", "(layer 1)", "(layer a b)", "(clear a b)", "(clear (point 0 0))"};
+  for (auto program : bad)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+  }
+
+  //a reset forgets the drawing and the layer
+  eval("(begin (layer top) (draw (point 0 0)))");
+  interp.reset();
+  REQUIRE(eval("(draw (point 1 1))").size() == 1);
+  REQUIRE(eval("(clear main)").empty());
+}
+
+TEST_CASE( "Test repeat and for", "[interpreter]" )
+{
+  Interpreter interp;
+  auto eval = [&interp](const std::string & program)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    Expression result = interp.eval();
+    interp.setGraphics();
+    return result;
+  };
+
+  REQUIRE(eval("(repeat 3 (draw (point 0 0)) 7)") == Expression(7.));
+  REQUIRE(interp.getGraphics().size() == 3);
+  REQUIRE(eval("(repeat 0 (draw (point 0 0)))") == Expression());
+  interp.clearGraphics();
+
+  //to is not reached, the value is the body's in the last iteration
+  REQUIRE(eval("(for i 0 5 2 (draw (point i (* i 10))) i)") == Expression(4.));
+  std::vector<Atom> graphics = interp.getGraphics();
+  REQUIRE(graphics.size() == 3);
+  REQUIRE(graphics[2].value.point_value.x == 4);
+  REQUIRE(graphics[2].value.point_value.y == 40);
+  interp.clearGraphics();
+
+  //counting down, and a step that does not add up exactly
+  eval("(for i 3 0 -1 (draw (point i 0)))");
+  REQUIRE(interp.getGraphics().size() == 3);
+  REQUIRE(interp.getGraphics()[2].value.point_value.x == 1);
+  interp.clearGraphics();
+  eval("(for x 0 1 0.1 (draw (point x 0)))");
+  REQUIRE(interp.getGraphics().size() == 10);
+  interp.clearGraphics();
+
+  //the loop variable is only bound inside the loop, an outer one comes back
+  REQUIRE(eval("(begin (define j 100) (for j 0 2 1 j) j)") == Expression(100.));
+  REQUIRE(eval("(begin (for k 0 2 1 k) 1)") == Expression(1.));
+  std::istringstream unbound("(+ k 1)");
+  REQUIRE(interp.parse(unbound));
+  REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+
+  std::vector<std::string> bad = {"(repeat 2)", "(repeat -1 1)", "(repeat 1.5 1)", "(repeat (point 0 0) 1)",
+                                  "(for i 0 1 0 i)", "(for i 0 1 i)", "(for 1 0 1 1 1)", "(for + 0 1 1 1)",
+                                  "(for i 0 (point 0 0) 1 i)", "(for m 0 2 1 (+ undefined 1))"};
+  for (auto program : bad)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+  }
+  std::istringstream leaked("(+ m 1)");
+  REQUIRE(interp.parse(leaked));
+  REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+}
+
+TEST_CASE( "Test lambda", "[interpreter]" )
+{
+  Interpreter interp;
+  auto eval = [&interp](const std::string & program)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    return interp.eval();
+  };
+
+  REQUIRE(eval("(begin (define sq (lambda (x) (* x x))) (sq 7))") == Expression(49.));
+  REQUIRE(eval("(begin (define hyp (lambda (a b) (pow (+ (sq a) (sq b)) 0.5))) (hyp 3 4))") == Expression(5.));
+  REQUIRE(eval("(begin sq)").head.type == LambdaType);
+
+  //a procedure sees the variables where it was made, after that call is over
+  REQUIRE(eval("(begin (define adder (lambda (n) (lambda (x) (+ x n)))) (define add5 (adder 5)) (add5 1))") == Expression(6.));
+  std::istringstream unbound("(+ n 1)");
+  REQUIRE(interp.parse(unbound));
+  REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+
+  //only the branch taken is evaluated, so a procedure can recurse
+  REQUIRE(eval("(begin (define fact (lambda (n) (if (< n 2) 1 (* n (fact (- n 1)))))) (fact 10))") == Expression(3628800.));
+
+  //a call in tail position does not grow the stack
+  REQUIRE(eval("(begin (define count (lambda (n acc) (if (= n 0) acc (begin (count (- n 1) (+ acc 1)))))) "
+                "(count 200000 0))") == Expression(200000.));
+
+  //recursion that is not in tail position fails once it nests too deeply,
+  //and the interpreter carries on after it
+  eval("(define depth (lambda (n) (if (= n 0) 0 (+ 1 (depth (- n 1))))))");
+  REQUIRE(eval("(depth 1000)") == Expression(1000.));
+  std::istringstream deep("(depth 100000)");
+  REQUIRE(interp.parse(deep));
+  REQUIRE_THROWS_WITH(interp.eval(), "Error: recursion too deep");
+  REQUIRE(eval("(depth 1000)") == Expression(1000.));
+
+  //a procedure can draw, defines inside it only live for the call
+  interp.setGraphics();
+  size_t before = interp.getGraphics().size();
+  eval("(begin (define branch (lambda (x y len depth) (if (= depth 0) 0 (begin (define y2 (+ y len)) "
+       "(draw (line (point x y) (point x y2))) (branch (- x 1) y2 (/ len 2) (- depth 1)) "
+       "(branch (+ x 1) y2 (/ len 2) (- depth 1)))))) (branch 0 0 10 5))");
+  interp.setGraphics();
+  REQUIRE(interp.getGraphics().size() == before + 31);
+  REQUIRE_THROWS_AS(eval("(begin y2)"), InterpreterSemanticError);
+
+  std::vector<std::string> bad = {"(lambda x)", "(lambda (x 1) x)", "(lambda (x x) x)", "(lambda (+) 1)",
+                                  "(sq 1 2)", "(pi 1)", "(undefined 1)", "(sq (point 0 0))",
+                                  "(define lambda 1)", "(define clear 1)", "(lambda (line) 1)",
+                                  "(for layer 0 1 1 1)", "(for draw 0 1 1 1)"};
+  for (auto program : bad)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+  }
+}
+
+TEST_CASE( "Test lambda frames are released", "[interpreter]" )
+{
+  Interpreter interp;
+  auto eval = [&interp](const std::string & program)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    return interp.eval();
+  };
+
+  //a helper defined inside a call keeps the frame it is bound in
+  eval("(define outer (lambda (n) (begin (define helper (lambda (x) (+ x n))) helper)))");
+  Expression helper = eval("(outer 1)");
+  std::weak_ptr<Frame> frame = helper.head.lambda().frame;
+  helper = Expression();
+  REQUIRE_FALSE(frame.expired());
+
+  //calls that keep defining helpers get the cycles collected, while the
+  //frames still in use and what they reach stay
+  REQUIRE(eval("(begin (define run (lambda (k) (begin (define make (lambda (a) (lambda (x) (+ x a)))) "
+               "(define add (make k)) (for i 0 3000 1 (outer i)) (add 1)))) (run 5))") == Expression(6.));
+  REQUIRE(frame.expired());
+  REQUIRE(eval("(begin (define add7 (outer 7)) (for i 0 3000 1 (outer i)) (add7 1))") == Expression(8.));
+}
+
+TEST_CASE( "Test lists", "[interpreter]" )
+{
+  Interpreter interp;
+  auto eval = [&interp](const std::string & program)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    return interp.eval();
+  };
+  auto list = [](const std::vector<double> & values)
+  {
+    return Expression(std::make_shared<const NumberList>(values));
+  };
+
+  REQUIRE(eval("(range 0 5 1)") == list({0, 1, 2, 3, 4}));
+  REQUIRE(eval("(range 1 0 -0.25)") == list({1, 0.75, 0.5, 0.25}));
+  REQUIRE(eval("(range 0 0 1)") == list({}));
+  REQUIRE(eval("(linspace 0 1 5)") == list({0, 0.25, 0.5, 0.75, 1}));
+  REQUIRE(eval("(linspace 2 3 1)") == list({2}));
+
+  //numbers go with every element, lists go element by element
+  REQUIRE(eval("(begin (define xs (range 1 4 1)) (+ xs 1 xs))") == list({3, 5, 7}));
+  REQUIRE(eval("(* 2 xs)") == list({2, 4, 6}));
+  REQUIRE(eval("(- xs)") == list({-1, -2, -3}));
+  REQUIRE(eval("(- 10 xs)") == list({9, 8, 7}));
+  REQUIRE(eval("(/ xs 2)") == list({0.5, 1, 1.5}));
+  REQUIRE(eval("(pow xs 2)") == list({1, 4, 9}));
+  REQUIRE(eval("(arctan xs 0)") == list({atan2(1, 0), atan2(2, 0), atan2(3, 0)}));
+
+  //the same as the builtins on one number
+  Expression sines = eval("(sin (linspace (- pi) pi 9))");
+  Expression cosines = eval("(cos (linspace (- pi) pi 9))");
+  for (int i = 0; i < 9; i++)
+  {
+    std::ostringstream program;
+    program << "(begin (define a" << i << " (+ (- pi) (* " << i << " (/ pi 4)))) (sin a" << i << "))";
+    REQUIRE((sines.head.list())[i] == eval(program.str()).head.value.num_value);
+    REQUIRE((cosines.head.list())[i] == Approx(cos(-M_PI + i * M_PI / 4)));
+  }
+
+  //infinities and NaN come out of the kernels as they would on their own
+  Expression infinite = eval("(/ (linspace 1 2 2) 0)");
+  REQUIRE(std::isinf((infinite.head.list())[0]));
+  REQUIRE((infinite.head.list())[1] > 0);
+  Expression undefined = eval("(* (/ (linspace 1 2 2) 0) 0)");
+  REQUIRE(std::isnan((undefined.head.list())[0]));
+
+  std::vector<std::string> bad = {"(range 0 1 0)", "(range 0 1)", "(range 0 1e12 1)", "(linspace 0 1 0)",
+                                  "(linspace 0 1 2.5)", "(+ xs (range 0 2 1))", "(+ xs True)", "(< xs xs)"};
+  for (auto program : bad)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+  }
+}
+
+TEST_CASE( "Test bulk geometry", "[interpreter]" )
+{
+  Interpreter interp;
+  auto draw = [&interp](const std::string & program)
+  {
+    interp.clearGraphics();
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE(interp.eval() == Expression());
+    interp.setGraphics();
+    return interp.getGraphics();
+  };
+
+  std::vector<Atom> graphics = draw("(points (range 0 3 1) 5)");
+  REQUIRE(graphics.size() == 3);
+  REQUIRE(graphics[2].type == PointType);
+  REQUIRE(graphics[2].value.point_value.x == 2);
+  REQUIRE(graphics[2].value.point_value.y == 5);
+
+  //n points make one polyline of n vertices
+  graphics = draw("(polyline (linspace 0 1 3) (pow (linspace 0 1 3) 2))");
+  REQUIRE(graphics.size() == 1);
+  REQUIRE(graphics[0].type == PolylineType);
+  const PointList & vertices = graphics[0].points();
+  REQUIRE(vertices.size() == 3);
+  REQUIRE(vertices[1].x == 0.5);
+  REQUIRE(vertices[1].y == 0.25);
+  REQUIRE(vertices[2].x == 1);
+  REQUIRE(vertices[2].y == 1);
+  graphics = draw("(polygon (range 0 3 1) (pow (range 0 3 1) 2))");
+  REQUIRE(graphics.size() == 1);
+  REQUIRE(graphics[0].type == PolygonType);
+  REQUIRE(graphics[0].points().size() == 3);
+
+  //of points they make a value that draw draws later
+  graphics = draw("(begin (define outline (polygon (point 0 0) (point 4 0) (point 4 3))) (draw outline outline))");
+  REQUIRE(graphics.size() == 2);
+  REQUIRE(graphics[1].type == PolygonType);
+  REQUIRE((graphics[1].points())[2].y == 3);
+
+  graphics = draw("(arcs 0 0 (range 1 4 1) 0 (linspace 0 pi 3))");
+  REQUIRE(graphics.size() == 3);
+  REQUIRE(graphics[2].type == ArcType);
+  REQUIRE(graphics[2].value.arc_value.start.x == 3);
+  REQUIRE(graphics[2].value.arc_value.span == Approx(M_PI));
+
+  //more than fits in one batch, in order
+  graphics = draw("(points (range 0 10000 1) (range 0 10000 1))");
+  REQUIRE(graphics.size() == 10000);
+  REQUIRE(graphics[9999].value.point_value.x == 9999);
+
+  std::vector<std::string> bad = {"(points (range 0 3 1))", "(points (range 0 3 1) (range 0 2 1))",
+                                  "(polyline (point 0 0) 1)", "(polygon (point 0 0))", "(arcs 0 0 1 0)",
+                                  "(polyline (range 0 1 1) (range 0 1 1))", "(polygon 1 2)",
+                                  "(polyline (range 0 0 1) (range 0 0 1))", "(define points 1)"};
+  for (auto program : bad)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+  }
+
+  //no outline is ever made with fewer than two vertices
+  REQUIRE_THROWS_AS(Expression(std::make_shared<const PointList>(), false), InterpreterSemanticError);
+  REQUIRE_THROWS_AS(Expression(std::make_shared<const PointList>(1), true), InterpreterSemanticError);
+  REQUIRE(Expression(std::make_shared<const PointList>(2), false).head.points().size() == 2);
+}
+
+TEST_CASE( "Test transforms", "[interpreter]" )
+{
+  Interpreter interp;
+  auto run = [&interp](const std::string & program)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    return interp.eval();
+  };
+
+  //anything drawable can be moved, it becomes a group of one
+  Expression moved = run("(translate 1 2 (point 0 0))");
+  REQUIRE(moved.head.type == GroupType);
+  REQUIRE(moved.head.instance().group->children.size() == 1);
+  REQUIRE(moved.head.instance().transform.e == 1);
+  REQUIRE(moved.head.instance().transform.f == 2);
+
+  //ten thousand instances of one shape are ten thousand matrices
+  interp.clearGraphics();
+  run("(begin (define glyph (group (line (point 0 0) (point 1 1)) (arc (point 0 0) (point 1 0) pi))) "
+      "(repeat 10000 (draw (translate 1 1 glyph))))");
+  interp.setGraphics();
+  std::vector<Atom> graphics = interp.getGraphics();
+  REQUIRE(graphics.size() == 10000);
+  REQUIRE(graphics.front().instance().group == graphics.back().instance().group);
+
+  std::vector<std::string> bad = {"(translate 1 2 3)", "(translate 1 (point 0 0))", "(rotate True (point 0 0))",
+                                  "(scale 2 (point 0 0) (point 1 1))", "(group (point 0 0) 1)"};
+  for (auto program : bad)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+  }
+}
+
+TEST_CASE( "Test curve", "[interpreter]" )
+{
+  Interpreter interp;
+  auto draw = [&interp](const std::string & program)
+  {
+    interp.clearGraphics();
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE(interp.eval() == Expression());
+    interp.setGraphics();
+    return interp.getGraphics();
+  };
+
+  //a straight line is never split further
+  std::vector<Atom> graphics = draw("(curve (lambda (t) (point t (* 2 t))) 0 1 0.01)");
+  REQUIRE(graphics.size() == 1);
+  REQUIRE(graphics[0].type == PolylineType);
+  PointList vertices = graphics[0].points();
+  REQUIRE(vertices.size() == 33);
+  REQUIRE(vertices.front().x == 0);
+  REQUIRE(vertices.back().y == 2);
+
+  //every piece of a circle is within tolerance of it
+  graphics = draw("(begin (define circle (lambda (t) (point (* 100 (cos t)) (* 100 (sin t))))) "
+                  "(curve circle 0 (* 2 pi) 0.05))");
+  REQUIRE(graphics.size() == 1);
+  vertices = graphics[0].points();
+  REQUIRE(vertices.size() > 33);
+  for (size_t i = 1; i < vertices.size(); i++)
+  {
+    double mx = (vertices[i - 1].x + vertices[i].x) / 2, my = (vertices[i - 1].y + vertices[i].y) / 2;
+    REQUIRE(100 - std::sqrt(mx * mx + my * my) <= 0.05);
+  }
+
+  //a tighter tolerance takes more vertices
+  size_t coarse = draw("(curve circle 0 (* 2 pi) 1)")[0].points().size();
+  REQUIRE(coarse < vertices.size());
+
+  std::vector<std::string> bad = {"(curve circle 0 1)", "(curve 1 0 1 0.1)", "(curve circle 0 1 0)",
+                                  "(curve (lambda (t) t) 0 1 0.1)", "(curve (lambda (a b) (point a b)) 0 1 0.1)"};
+  for (auto program : bad)
+  {
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+  }
+}
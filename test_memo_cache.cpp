@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <sstream>
+
+#include "memo_cache.hpp"
+#include "interpreter.hpp"
+#include "interpreter_semantic_error.hpp"
+
+static Expression evalWith(Interpreter & interp, const std::string & program)
+{
+  std::istringstream iss(program);
+  REQUIRE(interp.parse(iss));
+  Expression result;
+  REQUIRE_NOTHROW(result = interp.eval());
+  return result;
+}
+
+TEST_CASE( "Test memo cache table", "[memo]" )
+{
+  MemoCache cache(100);
+  REQUIRE(cache.capacity() == 128);
+
+  double args[2] = {1.5, 2};
+  double value = 0;
+  REQUIRE_FALSE(cache.find(1, args, 2, value));
+  cache.insert(1, args, 2, 7);
+  REQUIRE(cache.find(1, args, 2, value));
+  REQUIRE(value == 7);
+
+  //another builtin, another second argument or another sign of zero is
+  //another key
+  REQUIRE_FALSE(cache.find(2, args, 2, value));
+  args[1] = 3;
+  REQUIRE_FALSE(cache.find(1, args, 2, value));
+  double zero = 0, negativeZero = -0.0;
+  cache.insert(3, &zero, 1, 1);
+  REQUIRE_FALSE(cache.find(3, &negativeZero, 1, value));
+  double nan = std::numeric_limits<double>::quiet_NaN();
+  cache.insert(3, &nan, 1, 5);
+  REQUIRE(cache.find(3, &nan, 1, value));
+  REQUIRE(value == 5);
+
+  //builtin 0 is never kept
+  cache.insert(0, &zero, 1, 1);
+  REQUIRE_FALSE(cache.find(0, &zero, 1, value));
+
+  REQUIRE(cache.hits() == 2);
+  REQUIRE(cache.misses() == 5);
+  cache.clear();
+  REQUIRE(cache.hits() == 0);
+  REQUIRE(cache.misses() == 0);
+  REQUIRE_FALSE(cache.find(3, &nan, 1, value));
+
+  //a full table keeps the newest value in every slot it was given
+  MemoCache small(4);
+  for (int i = 0; i < 64; i++)
+  {
+    double x = i;
+    small.insert(1, &x, 1, i * 10);
+  }
+  for (int i = 0; i < 64; i++)
+  {
+    double x = i;
+    if (small.find(1, &x, 1, value))
+    {
+      REQUIRE(value == i * 10);
+    }
+  }
+  REQUIRE(small.hits() <= 4);
+}
+
+TEST_CASE( "Test memoized builtins", "[memo]" )
+{
+  MemoCache cache;
+  Interpreter memoized, plain;
+  memoized.setMemoCache(&cache);
+
+  //the same values with and without the cache, the second time from it
+  const char * programs[] = {"(sin (/ pi 8))", "(cos 2)", "(sin 0.0001)", "(log10 1000)",
+                             "(pow 2 0.5)", "(arctan 1 -1)", "(pow (- 0) -1)", "(pow 0 -1)"};
+  for (int round = 0; round < 2; round++)
+  {
+    for (const char * program : programs)
+    {
+      Expression a = evalWith(memoized, program), b = evalWith(plain, program);
+      REQUIRE(a == b);
+      REQUIRE(std::signbit(a.head.value.num_value) == std::signbit(b.head.value.num_value));
+    }
+  }
+  REQUIRE(cache.misses() == 8);
+  REQUIRE(cache.hits() == 8);
+
+  //a loop asking for the same value only works it out once
+  cache.clear();
+  REQUIRE(evalWith(memoized, "(begin (define f (lambda (x) (* 2 (sin (/ pi 8))))) "
+                             "(for i 0 100 1 (f i)))") == Expression(2 * std::sin(std::atan2(0, -1) / 8)));
+  REQUIRE(cache.misses() == 1);
+  REQUIRE(cache.hits() == 99);
+
+  //lists, other builtins and errors go around the cache
+  cache.clear();
+  evalWith(memoized, "(begin (sin (range 0 4 1)) (+ 1 2) (not True))");
+  std::istringstream iss("(sin True)");
+  REQUIRE(memoized.parse(iss));
+  REQUIRE_THROWS_AS(memoized.eval(), InterpreterSemanticError);
+  REQUIRE(cache.hits() + cache.misses() == 0);
+}
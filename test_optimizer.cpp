@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+
+#include "interpreter.hpp"
+#include "display_list.hpp"
+#include "display_list_optimizer.hpp"
+#include "svg_writer.hpp"
+#include "rasterizer.hpp"
+#include "test_config.hpp"
+#include "test_helpers.hpp"
+
+TEST_CASE( "Test optimizer drops duplicates", "[optimizer]" )
+{
+  DisplayList graphics = drawnBy("(begin (define wheel (arc (point 0 0) (point 10 0) (* 2 pi))) "
+                                 "(draw wheel (point 1 1) wheel (point 1 1) (point 2 2) wheel))");
+  REQUIRE(graphics.size() == 6);
+
+  OptimizedDisplayList optimized = optimizeDisplayList(graphics);
+  REQUIRE(optimized.graphics.size() == 3);
+  REQUIRE(optimized.stats.input == 6);
+  REQUIRE(optimized.stats.output == 3);
+  REQUIRE(optimized.stats.duplicates == 3);
+  REQUIRE(optimized.stats.ratio() == Approx(0.5));
+
+  //the first of each is kept in drawing order
+  REQUIRE(sameGeometry(optimized.graphics[0], graphics[0]));
+  REQUIRE(sameGeometry(optimized.graphics[1], graphics[1]));
+  REQUIRE(sameGeometry(optimized.graphics[2], graphics[4]));
+
+  //nothing to do
+  OptimizedDisplayList empty = optimizeDisplayList(DisplayList());
+  REQUIRE(empty.graphics.empty());
+  REQUIRE(empty.stats.ratio() == 1);
+}
+
+TEST_CASE( "Test optimizer merges collinear lines", "[optimizer]" )
+{
+  DisplayList graphics = drawnBy("(draw (line (point 0 0) (point 1 1)) (line (point 1 1) (point 2 2)) "
+                                 "(line (point 2 2) (point 5 5)) (line (point 5 5) (point 6 5)) "
+                                 "(line (point 6 5) (point 4 5)) (point 0 0) (line (point 4 5) (point 0 5)))");
+  OptimizedDisplayList optimized = optimizeDisplayList(graphics);
+  REQUIRE(optimized.stats.merged == 2);
+  REQUIRE(optimized.graphics.size() == 5);
+
+  Line diagonal = optimized.graphics[0].value.line_value;
+  REQUIRE(diagonal.first.x == 0);
+  REQUIRE(diagonal.first.y == 0);
+  REQUIRE(diagonal.second.x == 5);
+  REQUIRE(diagonal.second.y == 5);
+
+  //turning back is not carrying on, and a point in between stops the chain
+  REQUIRE(optimized.graphics[1].value.line_value.second.x == 6);
+  REQUIRE(optimized.graphics[2].value.line_value.second.x == 4);
+  REQUIRE(optimized.graphics[3].type == PointType);
+  REQUIRE(optimized.graphics[4].type == LineType);
+}
+
+TEST_CASE( "Test optimized drawing renders the same", "[optimizer]" )
+{
+  DisplayList graphics = drawnBy("(draw (line (point 10 10) (point 20 10)) (line (point 20 10) (point 30 10)) "
+                                 "(arc (point 20 20) (point 30 20) pi) (line (point 30 10) (point 30 30)))");
+  OptimizedDisplayList optimized = optimizeDisplayList(graphics);
+  REQUIRE(optimized.graphics.size() == 3);
+
+  //only where the merged pieces overlapped at the joint was drawn twice
+  //and came out darker, the optimized image is never darker anywhere
+  Rasterizer before(64, 64), after(64, 64);
+  before.draw(graphics);
+  after.draw(optimized.graphics);
+  const std::vector<unsigned char> & a = before.pixels();
+  const std::vector<unsigned char> & b = after.pixels();
+  REQUIRE(a.size() == b.size());
+  size_t changed = 0;
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    REQUIRE(int(b[i]) >= int(a[i]) - 1);
+    if (std::abs(int(a[i]) - int(b[i])) > 1)
+    {
+      changed++;
+    }
+  }
+  REQUIRE(changed < 16);
+}
+
+TEST_CASE( "Test joining polylines", "[optimizer]" )
+{
+  //a square drawn out of order with one side backwards, and a lone line
+  DisplayList graphics = drawnBy("(draw (line (point 0 0) (point 1 0)) (line (point 1 1) (point 0 1)) "
+                                 "(line (point 5 5) (point 6 7)) (line (point 1 1) (point 1 0)) "
+                                 "(point 3 3) (line (point 0 1) (point 0 0)))");
+  std::vector<Polyline> polylines = joinPolylines(graphics);
+  REQUIRE(polylines.size() == 2);
+
+  const Polyline & square = polylines[0];
+  REQUIRE(square.size() == 5);
+  REQUIRE(square.front().x == square.back().x);
+  REQUIRE(square.front().y == square.back().y);
+  for (size_t i = 1; i < square.size(); i++)
+  {
+    //every step goes along one side
+    double dx = square[i].x - square[i - 1].x, dy = square[i].y - square[i - 1].y;
+    REQUIRE(dx * dx + dy * dy == 1);
+  }
+
+  REQUIRE(polylines[1].size() == 2);
+  REQUIRE(polylines[1][0].x == 5);
+  REQUIRE(polylines[1][1].y == 7);
+
+  OptimizedDisplayList optimized = optimizeDisplayList(graphics);
+  REQUIRE(optimized.stats.polylines == 1);
+}
+
+TEST_CASE( "Test optimized SVG", "[optimizer]" )
+{
+  const std::string file = TEST_OUTPUT_DIR + "/test_optimized.svg";
+  DisplayList graphics = drawnBy("(draw (point 0 0) (line (point 0 0) (point 4 0)) (line (point 4 0) (point 4 4)) "
+                                 "(line (point 4 4) (point 0 0)) (line (point 4 4) (point 0 0)))");
+  REQUIRE(writeSvg(file, optimizeDisplayList(graphics)));
+
+  std::ifstream ifs(file);
+  std::stringstream contents;
+  contents << ifs.rdbuf();
+  std::string svg = contents.str();
+  std::remove(file.c_str());
+
+  //the point and the three distinct lines as one path
+  REQUIRE(countOf(svg, "<circle") == 1);
+  REQUIRE(countOf(svg, "<path") == 1);
+  REQUIRE(countOf(svg, " L") == 3);
+  REQUIRE(svg.find("</svg>") != std::string::npos);
+}
@@ -0,0 +1,265 @@
+#include "catch.hpp"
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <atomic>
+
+#include "interpreter.hpp"
+#include "expression.hpp"
+#include "display_list.hpp"
+#include "scene_graph.hpp"
+#include "rasterizer.hpp"
+#include "tile_rasterizer.hpp"
+#include "test_config.hpp"
+#include "test_helpers.hpp"
+
+// the golden images in tests/golden were made with
+//   slisp --render tests/golden/NAME.ppm --size 96x96 tests/NAME.slp
+static const int GOLDEN_SIZE = 96;
+
+// read a binary PPM into RGB bytes
+static bool readPPM(const std::string & fname, int & width, int & height, std::vector<unsigned char> & rgb)
+{
+  std::ifstream ifs(fname, std::ios::binary);
+  std::string magic;
+  int maxval;
+  if (!(ifs >> magic >> width >> height >> maxval) || magic != "P6" || maxval != 255)
+  {
+    return false;
+  }
+  ifs.get();
+  rgb.resize(size_t(width) * height * 3);
+  ifs.read(reinterpret_cast<char *>(rgb.data()), rgb.size());
+  return ifs.good();
+}
+
+// the red channel of one pixel
+static unsigned char red(const Rasterizer & raster, int x, int y)
+{
+  return raster.pixels()[(size_t(y) * raster.width() + x) * 4];
+}
+
+TEST_CASE( "Test rasterizer starts white", "[rasterizer]" )
+{
+  Rasterizer raster(8, 4);
+  REQUIRE(raster.width() == 8);
+  REQUIRE(raster.height() == 4);
+  REQUIRE(raster.pixels().size() == 8 * 4 * 4);
+  for (size_t i = 0; i < raster.pixels().size(); i++)
+  {
+    REQUIRE(raster.pixels()[i] == 255);
+  }
+}
+
+TEST_CASE( "Test rasterizer draws lines with antialiasing", "[rasterizer]" )
+{
+  Rasterizer raster(20, 20);
+  raster.draw(drawnBy("(draw (line (point 2 10.5) (point 18 10.5)))"));
+
+  //the row the line runs through is dark, the ones far away are untouched
+  REQUIRE(red(raster, 10, 10) < 128);
+  REQUIRE(red(raster, 10, 2) == 255);
+  REQUIRE(red(raster, 10, 17) == 255);
+  REQUIRE(red(raster, 0, 10) == 255);
+
+  //a line between pixel rows is spread over both of them
+  Rasterizer half(20, 20);
+  half.draw(drawnBy("(draw (line (point 2 10) (point 18 10)))"));
+  REQUIRE(red(half, 10, 9) > 0);
+  REQUIRE(red(half, 10, 9) < 255);
+  REQUIRE(red(half, 10, 10) > 0);
+  REQUIRE(red(half, 10, 10) < 255);
+}
+
+TEST_CASE( "Test rasterizer draws polygons closed", "[rasterizer]" )
+{
+  //a polyline leaves its last side open, a polygon draws it
+  Rasterizer open(20, 20), closed(20, 20);
+  open.draw(drawnBy("(draw (polyline (point 2 2.5) (point 18.5 2.5) (point 18.5 17.5)))"));
+  closed.draw(drawnBy("(draw (polygon (point 2 2.5) (point 18.5 2.5) (point 18.5 17.5)))"));
+  REQUIRE(red(open, 10, 2) < 128);
+  REQUIRE(red(open, 18, 10) < 128);
+  REQUIRE(red(open, 10, 10) == 255);
+  REQUIRE(red(closed, 10, 10) < 255);
+  REQUIRE(red(closed, 5, 15) == 255);
+}
+
+TEST_CASE( "Test rasterizer draws arcs counter clockwise", "[rasterizer]" )
+{
+  //half a circle from the right end over the top
+  Rasterizer raster(40, 40);
+  raster.draw(drawnBy("(draw (arc (point 20 20) (point 35 20) pi))"));
+  REQUIRE(red(raster, 20, 5) < 128);
+  REQUIRE(red(raster, 20, 34) == 255);
+
+  //a negative span goes under instead
+  Rasterizer under(40, 40);
+  under.draw(drawnBy("(draw (arc (point 20 20) (point 35 20) (- pi)))"));
+  REQUIRE(red(under, 20, 5) == 255);
+  REQUIRE(red(under, 20, 34) < 128);
+
+  //a full turn is a circle, the center stays white
+  Rasterizer circle(40, 40);
+  circle.draw(drawnBy("(draw (arc (point 20 20) (point 35 20) (* 2 pi)))"));
+  REQUIRE(red(circle, 20, 5) < 128);
+  REQUIRE(red(circle, 20, 34) < 128);
+  REQUIRE(red(circle, 5, 20) < 128);
+  REQUIRE(red(circle, 20, 20) == 255);
+}
+
+TEST_CASE( "Test rasterizer fit", "[rasterizer]" )
+{
+  DisplayList graphics = drawnBy("(draw (line (point -1000 -1000) (point 1000 1000)))");
+  Rasterizer raster(50, 50);
+  raster.fit(displayListBounds(graphics), 5);
+  raster.draw(graphics);
+
+  //the diagonal runs corner to corner inside the margin
+  REQUIRE(red(raster, 25, 25) < 128);
+  REQUIRE(red(raster, 6, 6) < 128);
+  REQUIRE(red(raster, 43, 43) < 128);
+  REQUIRE(red(raster, 2, 2) == 255);
+  REQUIRE(red(raster, 43, 6) == 255);
+}
+
+TEST_CASE( "Test rasterizer clipped drawing matches whole drawing", "[rasterizer]" )
+{
+  DisplayList graphics = drawnByFile(TEST_FILE_DIR + "/test_car.slp");
+  Rasterizer whole(64, 48);
+  whole.fit(displayListBounds(graphics), 4);
+  whole.draw(graphics);
+
+  //the same drawing done in 16x16 pieces
+  Rasterizer pieces(64, 48);
+  pieces.fit(displayListBounds(graphics), 4);
+  std::vector<float> scratch;
+  for (int y = 0; y < 48; y += 16)
+  {
+    for (int x = 0; x < 64; x += 16)
+    {
+      PixelRect clip = {x, y, x + 16, y + 16};
+      for (size_t i = 0; i < graphics.size(); i++)
+      {
+        pieces.draw(graphics[i], clip, scratch);
+      }
+    }
+  }
+  REQUIRE(whole.pixels() == pieces.pixels());
+}
+
+TEST_CASE( "Test rasterizer draws groups where they were moved", "[rasterizer]" )
+{
+  DisplayList graphics = drawnBy("(begin (define wheel (group (arc (point 0 0) (point 6 0) (* 2 pi)) "
+                                 "(line (point -6 0) (point 6 0)))) (draw (translate 10 20 wheel) "
+                                 "(translate 40 20 (rotate (/ pi 4) wheel)) (scale 3 (translate 10 3 wheel))))");
+  Rasterizer grouped(64, 48), flat(64, 48);
+  grouped.draw(graphics);
+  flat.draw(flattenDisplayList(graphics));
+  REQUIRE(grouped.pixels() == flat.pixels());
+  REQUIRE(red(grouped, 10, 20) < 255);
+  REQUIRE(red(grouped, 10, 30) == 255);
+}
+
+TEST_CASE( "Test thread pool runs every task once", "[rasterizer]" )
+{
+  ThreadPool pool(4);
+  REQUIRE(pool.size() == 4);
+
+  //run a few batches of uneven tasks through the same pool
+  for (size_t count : {1, 3, 1000})
+  {
+    std::vector<std::atomic<int>> runs(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      runs[i] = 0;
+    }
+    std::atomic<bool> badWorker(false);
+    pool.run(count, [&](size_t index, unsigned worker)
+    {
+      if (worker >= pool.size())
+      {
+        badWorker = true;
+      }
+      volatile double spin = 0;
+      for (size_t i = 0; i < (index % 7) * 1000; i++)
+      {
+        spin = spin + 1;
+      }
+      runs[index]++;
+    });
+    REQUIRE(badWorker == false);
+    for (size_t i = 0; i < count; i++)
+    {
+      REQUIRE(runs[i] == 1);
+    }
+  }
+}
+
+TEST_CASE( "Test tiled drawing matches serial drawing", "[rasterizer]" )
+{
+  //many overlapping primitives crossing tile edges
+  std::ostringstream program;
+  program << "(begin";
+  for (int i = 0; i < 200; i++)
+  {
+    int x = (i * 37) % 300, y = (i * 91) % 200;
+    program << " (draw (line (point " << x << " " << y << ") (point " << 300 - y << " " << x % 200 << ")))";
+    program << " (draw (arc (point " << x << " " << y << ") (point " << x + 5 + i % 40 << " " << y << ") " << (i % 13) - 6 << "))";
+    program << " (draw (point " << y << " " << x << "))";
+  }
+  program << ")";
+  DisplayList generated = drawnBy(program.str());
+  DisplayList car = drawnByFile(TEST_FILE_DIR + "/test_car.slp");
+
+  ThreadPool pool(4);
+  for (const DisplayList * graphics : {&generated, &car})
+  {
+    for (int tileSize : {1, 7, 32, DEFAULT_TILE_SIZE})
+    {
+      Rasterizer serial(301, 203);
+      serial.fit(displayListBounds(*graphics), 3);
+      serial.draw(*graphics);
+
+      Rasterizer tiled(301, 203);
+      tiled.fit(displayListBounds(*graphics), 3);
+      drawTiled(tiled, *graphics, pool, tileSize);
+
+      INFO(tileSize);
+      REQUIRE(serial.pixels() == tiled.pixels());
+    }
+  }
+}
+
+TEST_CASE( "Test rasterizer against golden images", "[rasterizer]" )
+{
+  std::vector<std::string> names = {"test_arc", "test_arc_simple", "test_car", "test_line", "test_point"};
+  for (auto name : names)
+  {
+    DisplayList graphics = drawnByFile(TEST_FILE_DIR + "/" + name + ".slp");
+    Rasterizer raster(GOLDEN_SIZE, GOLDEN_SIZE);
+    raster.fit(displayListBounds(graphics), 10);
+    raster.draw(graphics);
+
+    int width, height;
+    std::vector<unsigned char> golden;
+    INFO(name);
+    REQUIRE(readPPM(TEST_FILE_DIR + "/golden/" + name + ".ppm", width, height, golden));
+    REQUIRE(width == GOLDEN_SIZE);
+    REQUIRE(height == GOLDEN_SIZE);
+
+    //allow for rounding differences between compilers, nothing more
+    int worst = 0;
+    for (int i = 0; i < width * height; i++)
+    {
+      for (int c = 0; c < 3; c++)
+      {
+        int difference = std::abs(int(raster.pixels()[i * 4 + c]) - int(golden[i * 3 + c]));
+        worst = std::max(worst, difference);
+      }
+    }
+    REQUIRE(worst <= 1);
+  }
+}
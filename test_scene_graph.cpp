@@ -0,0 +1,125 @@
+#include "catch.hpp"
+
+#include <string>
+#include <sstream>
+#include <cmath>
+
+#include "interpreter.hpp"
+#include "display_list.hpp"
+#include "scene_graph.hpp"
+#include "test_helpers.hpp"
+
+TEST_CASE( "Test groups and transforms", "[scene graph]" )
+{
+  //a shape drawn in two places shares its atoms
+  DisplayList graphics = drawnBy("(begin (define wing (group (line (point 0 0) (point 10 0)) (arc (point 0 0) (point 5 0) pi))) "
+                                 "(draw (translate 100 50 wing) (rotate (/ pi 2) (scale 2 wing))))");
+  REQUIRE(graphics.size() == 2);
+  REQUIRE(graphics[0].type == GroupType);
+  REQUIRE(graphics[0].instance().group == graphics[1].instance().group);
+  REQUIRE_FALSE(sameGeometry(graphics[0], graphics[1]));
+
+  DisplayList flat = flattenDisplayList(graphics);
+  REQUIRE(flat.size() == 4);
+  REQUIRE(flat[0].type == LineType);
+  REQUIRE(flat[0].value.line_value.first.x == 100);
+  REQUIRE(flat[0].value.line_value.second.x == 110);
+  REQUIRE(flat[0].value.line_value.second.y == 50);
+
+  //scaled then turned a quarter counter clockwise, so right becomes up
+  REQUIRE(std::fabs(flat[2].value.line_value.second.x) < 1e-12);
+  REQUIRE(flat[2].value.line_value.second.y == Approx(-20));
+  REQUIRE(flat[3].type == ArcType);
+  REQUIRE(flat[3].value.arc_value.start.y == Approx(-10));
+  REQUIRE(flat[3].value.arc_value.span == Approx(M_PI));
+
+  //a group covers what it draws once it is moved
+  Bounds bounds = atomBounds(graphics[0]);
+  REQUIRE(bounds.left == Approx(95));
+  REQUIRE(bounds.right == Approx(110));
+  REQUIRE(bounds.top == Approx(45));
+  REQUIRE(bounds.bottom == Approx(50));
+  Bounds both = displayListBounds(flat);
+  REQUIRE(displayListBounds(graphics).left == Approx(both.left));
+  REQUIRE(displayListBounds(graphics).top == Approx(both.top));
+
+  //transforms compose, the shape is never copied
+  DisplayList nested = drawnBy("(draw (translate 1 2 (translate 3 4 (group (point 0 0)))))");
+  REQUIRE(nested[0].instance().group->children.size() == 1);
+  REQUIRE(nested[0].instance().group->children[0].type == PointType);
+  REQUIRE(nested[0].instance().transform.e == 4);
+  REQUIRE(nested[0].instance().transform.f == 6);
+
+  //an instance drawn twice is one shape and one matrix, only pointed to
+  DisplayList twice = drawnBy("(begin (define moved (translate 1 2 (group (point 0 0)))) (draw moved moved))");
+  REQUIRE(twice[0].value.shared_value == twice[1].value.shared_value);
+}
+
+TEST_CASE( "Test cached group bounds", "[scene graph]" )
+{
+  DisplayList graphics = drawnBy("(begin (define leaf (group (line (point 0 0) (point 4 2)) (point 10 10))) "
+                                 "(define branch (group leaf (translate 100 0 (scale 2 leaf)))) (draw branch))");
+  const Group & branch = *graphics[0].instance().group;
+  const Group & leaf = *branch.children[0].instance().group;
+
+  //a group's box is that of its children, a group inside moved along with it
+  Bounds bounds = groupBounds(leaf);
+  REQUIRE(bounds.left == 0);
+  REQUIRE(bounds.top == 0);
+  REQUIRE(bounds.right == 12);
+  REQUIRE(bounds.bottom == 12);
+  bounds = groupBounds(branch);
+  REQUIRE(bounds.right == 124);
+  REQUIRE(bounds.bottom == 24);
+  REQUIRE(atomBounds(graphics[0]).right == 124);
+
+  //a quarter turn swaps width and height
+  Transform turn = {0, -1, 1, 0, 0, 0};
+  Bounds turned = transformBounds(turn, groupBounds(leaf));
+  REQUIRE(turned.width() == Approx(12));
+  REQUIRE(turned.top == Approx(-12));
+  Point back = transformPoint(invertTransform(turn), transformPoint(turn, Point{3, 4}));
+  REQUIRE(back.x == Approx(3));
+  REQUIRE(back.y == Approx(4));
+
+  //an empty group has an empty box, moved or not
+  std::shared_ptr<const Group> empty = makeGroup(std::vector<Atom>());
+  REQUIRE(groupBounds(*empty).empty());
+  REQUIRE(transformBounds(turn, groupBounds(*empty)).empty());
+  REQUIRE(atomBounds(Expression(empty, turn).head).empty());
+}
+
+TEST_CASE( "Test hit testing", "[scene graph]" )
+{
+  DisplayList graphics = drawnBy("(draw (line (point 0 0) (point 10 0)) (arc (point 0 0) (point 10 0) (/ pi 2)) "
+                                 "(polygon (point 20 0) (point 30 0) (point 30 10)) (point 50 50))");
+  REQUIRE(hitTest(graphics, Point{5, 0.3}, 0.5) == 0);
+  REQUIRE(hitTest(graphics, Point{5, 2}, 0.5) == HIT_NONE);
+
+  //an arc is hit only where it sweeps, up from the right
+  REQUIRE(hitTest(graphics, Point{7.07, -7.07}, 0.5) == 1);
+  REQUIRE(hitTest(graphics, Point{7.07, 7.07}, 0.5) == HIT_NONE);
+
+  //a polygon has its closing side, and where atoms cross the last drawn wins
+  REQUIRE(hitTest(graphics, Point{25, 5}, 0.5) == 2);
+  REQUIRE(hitTest(graphics, Point{10, 0}, 0.5) == 1);
+  REQUIRE(hitTest(graphics, Point{51, 51}, 0.5) == 3);
+}
+
+TEST_CASE( "Test hit testing groups", "[scene graph]" )
+{
+  DisplayList graphics = drawnBy("(begin (define tick (group (line (point 0 0) (point 0 10)))) "
+                                 "(draw (group (translate 100 0 tick) (translate 200 0 (scale 4 tick)))))");
+  REQUIRE(hitTest(graphics, Point{100.3, 5}, 0.5) == 0);
+  REQUIRE(hitTest(graphics, Point{100, 11}, 0.5) == HIT_NONE);
+  REQUIRE(hitTest(graphics, Point{150, 5}, 0.5) == HIT_NONE);
+
+  //the tolerance is scaled with the group, so it is the same on screen
+  REQUIRE(hitTest(graphics, Point{200.4, 39}, 0.5) == 0);
+  REQUIRE(hitTest(graphics, Point{200.6, 39}, 0.5) == HIT_NONE);
+
+  //a group's own coordinates
+  const Group & outer = *graphics[0].instance().group;
+  REQUIRE(hitGroup(outer, Point{200, 20}, 0.1));
+  REQUIRE_FALSE(hitGroup(outer, Point{0, 5}, 0.1));
+}
@@ -0,0 +1,193 @@
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "interpreter.hpp"
+#include "display_list.hpp"
+#include "sld_format.hpp"
+#include "test_config.hpp"
+
+static const std::string SLD_FILE = TEST_OUTPUT_DIR + "/test_output.sld";
+
+// read a whole file into doubles so the data is 8 byte aligned like a mapping
+static std::vector<double> readFile(const std::string & fname, size_t & size)
+{
+  std::ifstream ifs(fname, std::ios::binary | std::ios::ate);
+  size = ifs.tellg();
+  std::vector<double> data(size / sizeof(double) + 1);
+  ifs.seekg(0);
+  ifs.read(reinterpret_cast<char *>(data.data()), size);
+  return data;
+}
+
+static bool sameAtom(const Atom & a, const Atom & b)
+{
+  if (a.type != b.type)
+  {
+    return false;
+  }
+  if (a.type == PointType)
+  {
+    return a.value.point_value.x == b.value.point_value.x && a.value.point_value.y == b.value.point_value.y;
+  }
+  if (a.type == LineType)
+  {
+    return a.value.line_value.first.x == b.value.line_value.first.x
+      && a.value.line_value.first.y == b.value.line_value.first.y
+      && a.value.line_value.second.x == b.value.line_value.second.x
+      && a.value.line_value.second.y == b.value.line_value.second.y;
+  }
+  if (a.type == PolylineType || a.type == PolygonType)
+  {
+    return a.points() == b.points();
+  }
+  return a.value.arc_value.center.x == b.value.arc_value.center.x
+    && a.value.arc_value.center.y == b.value.arc_value.center.y
+    && a.value.arc_value.start.x == b.value.arc_value.start.x
+    && a.value.arc_value.start.y == b.value.arc_value.start.y
+    && a.value.arc_value.span == b.value.arc_value.span;
+}
+
+TEST_CASE( "Test .sld round trip", "[sld]" )
+{
+  std::ifstream ifs(TEST_FILE_DIR + "/test_car.slp");
+  REQUIRE(ifs.good() == true);
+  Interpreter interp;
+  REQUIRE(interp.parse(ifs));
+  REQUIRE_NOTHROW(interp.eval());
+  interp.setGraphics();
+  DisplayList graphics = interp.getGraphics();
+  graphics.push_back(graphics.front());
+  graphics.front().type = PointType;
+  graphics.front().value.point_value.x = 3;
+  graphics.front().value.point_value.y = -4;
+  std::vector<Point> outline = {{0, 0}, {40, -70}, {90, 10}, {20, 30}};
+  graphics.insert(graphics.begin() + 2, Expression(std::make_shared<const PointList>(outline), true).head);
+  outline.pop_back();
+  graphics.push_back(Expression(std::make_shared<const PointList>(outline), false).head);
+
+  REQUIRE(writeSld(SLD_FILE, graphics));
+  size_t size;
+  std::vector<double> data = readFile(SLD_FILE, size);
+  std::remove(SLD_FILE.c_str());
+
+  SldView view;
+  std::string error;
+  REQUIRE(view.attach(data.data(), size, error));
+  REQUIRE(view.size() == graphics.size());
+
+  //the header bounds are those of the display list
+  Bounds expected = displayListBounds(graphics);
+  REQUIRE(view.bounds().left == expected.left);
+  REQUIRE(view.bounds().top == expected.top);
+  REQUIRE(view.bounds().right == expected.right);
+  REQUIRE(view.bounds().bottom == expected.bottom);
+
+  //grouped by type, in drawing order within each type, polylines and
+  //polygons are both paths
+  DisplayList loaded = view.displayList();
+  size_t next = 0;
+  for (Type type : {PointType, LineType, ArcType, PolylineType})
+  {
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+      if ((graphics[i].type == PolygonType ? PolylineType : graphics[i].type) == type)
+      {
+        REQUIRE(sameAtom(graphics[i], loaded[next++]));
+      }
+    }
+  }
+  REQUIRE(next == loaded.size());
+
+  //a path that runs past the vertices
+  SldHeader * header = reinterpret_cast<SldHeader *>(data.data());
+  header->vertexCount -= 2;
+  REQUIRE_FALSE(view.attach(data.data(), size, error));
+  REQUIRE(error == "Error: corrupt .sld path");
+}
+
+TEST_CASE( "Test .sld reads version 1", "[sld]" )
+{
+  DisplayList graphics;
+  Atom point;
+  point.type = PointType;
+  point.value.point_value.x = 5;
+  point.value.point_value.y = 6;
+  graphics.push_back(point);
+  REQUIRE(writeSld(SLD_FILE, graphics));
+  size_t size;
+  std::vector<double> data = readFile(SLD_FILE, size);
+  std::remove(SLD_FILE.c_str());
+
+  //the same drawing with the 64 byte header of version 1
+  SldHeader * header = reinterpret_cast<SldHeader *>(data.data());
+  header->version = 1;
+  size_t v2Only = sizeof(SldHeader) - SLD_V1_HEADER_SIZE;
+  std::vector<double> v1(data.size());
+  std::memcpy(v1.data(), data.data(), SLD_V1_HEADER_SIZE);
+  std::memcpy(reinterpret_cast<char *>(v1.data()) + SLD_V1_HEADER_SIZE,
+              reinterpret_cast<char *>(data.data()) + sizeof(SldHeader), size - sizeof(SldHeader));
+
+  SldView view;
+  std::string error;
+  REQUIRE(view.attach(v1.data(), size - v2Only, error));
+  REQUIRE(view.size() == 1);
+  REQUIRE(sameAtom(view.atom(0), point));
+}
+
+TEST_CASE( "Test .sld rejects bad files", "[sld]" )
+{
+  DisplayList graphics;
+  Atom line;
+  line.type = LineType;
+  line.value.line_value.first.x = 0;
+  line.value.line_value.first.y = 0;
+  line.value.line_value.second.x = 1;
+  line.value.line_value.second.y = 1;
+  graphics.push_back(line);
+  REQUIRE(writeSld(SLD_FILE, graphics));
+  size_t size;
+  std::vector<double> data = readFile(SLD_FILE, size);
+  std::remove(SLD_FILE.c_str());
+
+  SldView view;
+  std::string error;
+  REQUIRE(view.attach(data.data(), size, error));
+
+  //cut short
+  REQUIRE_FALSE(view.attach(data.data(), size - 1, error));
+  REQUIRE(error == "Error: truncated .sld file");
+  REQUIRE(view.size() == 0);
+  REQUIRE_FALSE(view.attach(data.data(), 10, error));
+  REQUIRE(error == "Error: not a .sld file");
+
+  //a count so large it would overflow a byte size
+  SldHeader * header = reinterpret_cast<SldHeader *>(data.data());
+  header->arcCount = ~uint64_t(0) / 2;
+  REQUIRE_FALSE(view.attach(data.data(), size, error));
+  REQUIRE(error == "Error: truncated .sld file");
+  header->arcCount = 0;
+
+  //a newer version
+  header->version = SLD_VERSION + 1;
+  REQUIRE_FALSE(view.attach(data.data(), size, error));
+  REQUIRE(error == "Error: unsupported .sld version");
+
+  //not a .sld file at all
+  std::memcpy(header->magic, "PK\3\4", 4);
+  REQUIRE_FALSE(view.attach(data.data(), size, error));
+  REQUIRE(error == "Error: not a .sld file");
+
+  //an empty drawing is valid
+  REQUIRE(writeSld(SLD_FILE, DisplayList()));
+  data = readFile(SLD_FILE, size);
+  std::remove(SLD_FILE.c_str());
+  REQUIRE(view.attach(data.data(), size, error));
+  REQUIRE(view.size() == 0);
+  REQUIRE(view.bounds().empty());
+}
@@ -0,0 +1,77 @@
+#include "catch.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.hpp"
+
+TEST_CASE( "Test queue capacity and order", "[queue]" )
+{
+  SpscQueue<int> queue(5);
+  REQUIRE(queue.capacity() == 8);
+  REQUIRE(queue.empty());
+
+  //go around the ring a few times, a full queue refuses and keeps its values
+  int next = 0, expected = 0;
+  for (int round = 0; round < 5; round++)
+  {
+    while (queue.tryPush(next))
+    {
+      next++;
+    }
+    REQUIRE(next - expected == 8);
+    int value;
+    for (int i = 0; i < 5; i++)
+    {
+      REQUIRE(queue.tryPop(value));
+      REQUIRE(value == expected++);
+    }
+  }
+  int value;
+  while (queue.tryPop(value))
+  {
+    REQUIRE(value == expected++);
+  }
+  REQUIRE(expected == next);
+  REQUIRE(queue.empty());
+}
+
+TEST_CASE( "Test queue between two threads", "[queue]" )
+{
+  //a small ring so both sides keep finding it full or empty
+  SpscQueue<size_t> queue(16);
+  const size_t count = 200000;
+  std::thread producer([&queue, count]
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      while (!queue.tryPush(i))
+      {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::vector<size_t> received;
+  size_t value;
+  while (received.size() < count)
+  {
+    if (queue.tryPop(value))
+    {
+      received.push_back(value);
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  bool inOrder = true;
+  for (size_t i = 0; i < count; i++)
+  {
+    inOrder = inOrder && received[i] == i;
+  }
+  REQUIRE(inOrder);
+  REQUIRE(queue.empty());
+}
@@ -0,0 +1,182 @@
+#include "catch.hpp"
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+
+#include "interpreter.hpp"
+#include "interpreter_semantic_error.hpp"
+#include "display_list.hpp"
+#include "svg_writer.hpp"
+#include "test_config.hpp"
+#include "test_helpers.hpp"
+
+static const std::string SVG_FILE = TEST_OUTPUT_DIR + "/test_output.svg";
+
+static std::string readFile(const std::string & fname)
+{
+  std::ifstream ifs(fname);
+  std::stringstream contents;
+  contents << ifs.rdbuf();
+  return contents.str();
+}
+
+// run a program with its drawing streamed into SVG_FILE
+static std::string svgOf(const std::string & program)
+{
+  SvgWriter writer;
+  REQUIRE(writer.open(SVG_FILE));
+  Interpreter interp;
+  interp.setGraphicsSink(&writer);
+  std::istringstream iss(program);
+  REQUIRE(interp.parse(iss));
+  REQUIRE_NOTHROW(interp.eval());
+
+  //everything went to the writer, nothing was kept
+  interp.setGraphics();
+  REQUIRE(interp.getGraphics().empty());
+  REQUIRE(writer.close());
+  std::string svg = readFile(SVG_FILE);
+  std::remove(SVG_FILE.c_str());
+  return svg;
+}
+
+TEST_CASE( "Test SVG document structure", "[svg]" )
+{
+  std::string svg = svgOf("(draw (point 1 2) (line (point 0 0) (point 10 20)))");
+
+  REQUIRE(svg.find("<?xml") == 0);
+  REQUIRE(svg.find("<circle cx=\"2\" cy=\"3\" r=\"1\" fill=\"black\"/>") != std::string::npos);
+  REQUIRE(svg.find("<path d=\"M0,0 L10,20\"/>") != std::string::npos);
+  REQUIRE(svg.substr(svg.size() - 12) == "</g>\n</svg>\n");
+
+  //the viewBox was filled in with the bounds padded by the pen width
+  REQUIRE(svg.find(" viewBox=\"-1 -1 12 22\"") != std::string::npos);
+}
+
+TEST_CASE( "Test SVG arcs", "[svg]" )
+{
+  //a quarter turn counter clockwise from the right goes up
+  std::string quarter = svgOf("(draw (arc (point 0 0) (point 10 0) (/ pi 2)))");
+  REQUIRE(quarter.find("<path d=\"M10,0 A10 10 0 0 0 6.123233996e-16,-10\"/>") != std::string::npos);
+
+  //a negative span turns the other way
+  std::string under = svgOf("(draw (arc (point 0 0) (point 10 0) (- (/ pi 2))))");
+  REQUIRE(under.find(" A10 10 0 0 1 6.123233996e-16,10\"") != std::string::npos);
+
+  //more than half a turn is the large arc
+  std::string large = svgOf("(draw (arc (point 0 0) (point 10 0) (* 1.5 pi)))");
+  REQUIRE(large.find(" A10 10 0 1 0 ") != std::string::npos);
+
+  //a full circle is drawn in two halves
+  std::string circle = svgOf("(draw (arc (point 0 0) (point 10 0) (* 2 pi)))");
+  REQUIRE(circle.find(" A10 10 0 0 0 -10,") != std::string::npos);
+  REQUIRE(circle.find(" A10 10 0 0 0 10,") != std::string::npos);
+  REQUIRE(circle.find(" viewBox=\"-11 -11 22 22\"") != std::string::npos);
+}
+
+TEST_CASE( "Test SVG outlines", "[svg]" )
+{
+  //an outline is one path however many vertices it has, a polygon closes
+  std::string svg = svgOf("(begin (polyline (range 0 3 1) 5) (polygon (point 0 0) (point 4 0) (point 4 3)))");
+  REQUIRE(svg.find("<path d=\"M0,5 L1,5 L2,5\"/>") != std::string::npos);
+  REQUIRE(svg.find("<path d=\"M0,0 L4,0 L4,3 Z\"/>") == std::string::npos);
+  svg = svgOf("(draw (polygon (point 0 0) (point 4 0) (point 4 3)))");
+  REQUIRE(svg.find("<path d=\"M0,0 L4,0 L4,3 Z\"/>") != std::string::npos);
+}
+
+TEST_CASE( "Test SVG instances", "[svg]" )
+{
+  //the strokes of a shape are defined once, with a shape inside it moved
+  //into the definition
+  std::string svg = svgOf("(begin (define tick (group (line (point 0 0) (point 0 1)))) "
+                          "(define pair (group tick (translate 5 0 tick))) "
+                          "(draw (translate 10 10 pair) (translate 20 10 pair) (scale 2 tick)))");
+  REQUIRE(countOf(svg, "<defs>") == 2);
+  REQUIRE(svg.find("<g id=\"shape0\">\n<path d=\"M0,0 L0,1\"/>\n<path d=\"M5,0 L5,1\"/>\n</g>") != std::string::npos);
+  REQUIRE(svg.find("<use xlink:href=\"#shape0\" transform=\"matrix(1 0 0 1 20 10)\" stroke-width=\"1\"/>") != std::string::npos);
+  REQUIRE(svg.find("<use xlink:href=\"#shape1\" transform=\"matrix(2 0 0 2 0 0)\" stroke-width=\"0.5\"/>") != std::string::npos);
+
+  //the viewBox covers the instances where they were put
+  REQUIRE(svg.find(" viewBox=\"-1 -1 27 13\"") != std::string::npos);
+
+  //points are not shared, they keep their size wherever they end up
+  svg = svgOf("(begin (define dot (group (point 0 0))) (draw (scale 2 (translate 3 4 dot))))");
+  REQUIRE(svg.find("<circle cx=\"7\" cy=\"9\" r=\"1\" fill=\"black\"/>") != std::string::npos);
+}
+
+TEST_CASE( "Test SVG instance pen", "[svg]" )
+{
+  //a scaled instance is stroked as wide as a path drawn where it ends up,
+  //the width it inherits is scaled by its transform along with the shape
+  std::string svg = svgOf("(begin (define tick (group (line (point 0 0) (point 0 1)))) "
+                          "(draw (scale 10 tick) (rotate 1 (scale 0.25 tick)) (line (point 0 0) (point 5 5))))");
+  double pen = std::stod(svg.substr(svg.find("stroke-width=\"") + 14));
+  REQUIRE(pen == 1);
+  REQUIRE(svg.find("<path d=\"M0,0 L5,5\"/>") != std::string::npos);
+  size_t found = 0;
+  for (size_t at = svg.find("<use"); at != std::string::npos; at = svg.find("<use", at + 1))
+  {
+    std::istringstream matrix(svg.substr(svg.find("matrix(", at) + 7));
+    double a, b, c, d;
+    matrix >> a >> b >> c >> d;
+    double width = std::stod(svg.substr(svg.find("stroke-width=\"", at) + 14));
+    REQUIRE(width * std::sqrt(std::fabs(a * d - b * c)) == Approx(pen));
+    found++;
+  }
+  REQUIRE(found == 2);
+  REQUIRE(svg.find("vector-effect") == std::string::npos);
+}
+
+TEST_CASE( "Test SVG of a display list", "[svg]" )
+{
+  std::ifstream ifs(TEST_FILE_DIR + "/test_car.slp");
+  REQUIRE(ifs.good() == true);
+  Interpreter interp;
+  REQUIRE(interp.parse(ifs));
+  REQUIRE_NOTHROW(interp.eval());
+  interp.setGraphics();
+  DisplayList graphics = interp.getGraphics();
+
+  REQUIRE(writeSvg(SVG_FILE, graphics));
+  std::string svg = readFile(SVG_FILE);
+  std::remove(SVG_FILE.c_str());
+  size_t elements = 0;
+  for (size_t at = svg.find("<path"); at != std::string::npos; at = svg.find("<path", at + 1))
+  {
+    elements++;
+  }
+  for (size_t at = svg.find("<circle"); at != std::string::npos; at = svg.find("<circle", at + 1))
+  {
+    elements++;
+  }
+  REQUIRE(elements == graphics.size());
+
+  //a file that cannot be created is reported
+  REQUIRE_FALSE(writeSvg(TEST_OUTPUT_DIR + "/missing/test_output.svg", graphics));
+}
+
+TEST_CASE( "Test SVG clear", "[svg]" )
+{
+  //clearing starts the drawing over, what was written before is blanked out
+  std::string cleared = svgOf("(begin (draw (line (point 0 0) (point 100 200)) (point 5 5)) (clear) (draw (point 1 2)))");
+  std::string fresh = svgOf("(draw (point 1 2))");
+  REQUIRE(cleared.size() > fresh.size());
+  REQUIRE(cleared.substr(0, fresh.size()) == fresh);
+  REQUIRE(cleared.find_first_not_of(' ', fresh.size()) == std::string::npos);
+
+  //a single layer cannot be taken out of what was streamed
+  SvgWriter writer;
+  REQUIRE(writer.open(SVG_FILE));
+  Interpreter interp;
+  interp.setGraphicsSink(&writer);
+  std::istringstream iss("(begin (draw (point 1 2)) (clear main))");
+  REQUIRE(interp.parse(iss));
+  REQUIRE_THROWS_WITH(interp.eval(), "Error: this output cannot clear a single layer");
+  REQUIRE_FALSE(writer.clearLayer("main"));
+  REQUIRE(writer.clearLayer(""));
+  writer.close();
+  std::remove(SVG_FILE.c_str());
+}
@@ -0,0 +1,133 @@
+// module includes
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    remaining = 0;
+    generation = 0;
+    stopping = false;
+    for (unsigned i = 0; i < threads; i++)
+    {
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    //worker 0 is whoever calls run
+    for (unsigned i = 1; i < threads; i++)
+    {
+        this->threads.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+}
+
+unsigned ThreadPool::size() const
+{
+    return queues.size();
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t, unsigned)> & task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    job = task;
+    remaining = count;
+
+    //deal the tasks out in contiguous blocks, neighbouring tasks tend to
+    //touch neighbouring memory
+    for (unsigned worker = 0; worker < size(); worker++)
+    {
+        std::lock_guard<std::mutex> guard(queues[worker]->lock);
+        size_t first = count * worker / size();
+        size_t last = count * (worker + 1) / size();
+        for (size_t index = first; index < last; index++)
+        {
+            queues[worker]->tasks.push_back(index);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        generation++;
+    }
+    wake.notify_all();
+
+    drain(0);
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [this] { return remaining == 0; });
+}
+
+//the loop of a background worker, it sleeps until a batch starts
+void ThreadPool::work(unsigned worker)
+{
+    size_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping)
+            {
+                return;
+            }
+            seen = generation;
+        }
+        drain(worker);
+    }
+}
+
+//runs tasks until there are none left anywhere
+void ThreadPool::drain(unsigned worker)
+{
+    size_t index;
+    while (next(worker, index))
+    {
+        job(index, worker);
+        if (--remaining == 0)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            finished.notify_all();
+        }
+    }
+}
+
+//takes the newest task of the worker's own deque, or steals the oldest
+//task of another worker
+bool ThreadPool::next(unsigned worker, size_t & index)
+{
+    {
+        std::lock_guard<std::mutex> guard(queues[worker]->lock);
+        if (!queues[worker]->tasks.empty())
+        {
+            index = queues[worker]->tasks.back();
+            queues[worker]->tasks.pop_back();
+            return true;
+        }
+    }
+    for (unsigned i = 1; i < size(); i++)
+    {
+        Queue & victim = *queues[(worker + i) % size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            index = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+// system includes
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+// A ThreadPool runs batches of independent tasks on a fixed set of
+// threads. Every worker has its own deque of task indices, it takes work
+// from the back of its own deque and, once that is empty, steals from the
+// front of the others, so uneven tasks still keep every core busy.
+class ThreadPool
+{
+public:
+
+  // a pool of threads workers, 0 means one per hardware thread
+  explicit ThreadPool(unsigned threads = 0);
+  ~ThreadPool();
+
+  // the number of workers, including the thread that calls run
+  unsigned size() const;
+
+  // call task(index, worker) for every index in [0, count) and wait until
+  // all are done. worker is in [0, size()) and no two tasks run on the
+  // same worker at once, so it can pick per worker scratch memory.
+  // the calling thread works as worker 0
+  void run(size_t count, const std::function<void(size_t, unsigned)> & task);
+
+private:
+
+  struct Queue
+  {
+    std::mutex lock;
+    std::deque<size_t> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> threads;
+
+  std::mutex lock;
+  std::condition_variable wake;
+  std::condition_variable finished;
+  std::function<void(size_t, unsigned)> job;
+  std::atomic<size_t> remaining;
+  size_t generation;
+  bool stopping;
+
+  void work(unsigned worker);
+  void drain(unsigned worker);
+  bool next(unsigned worker, size_t & index);
+};
+
+#endif
@@ -0,0 +1,49 @@
+// module includes
+#include "tile_rasterizer.hpp"
+
+// system includes
+#include <cstdint>
+#include <algorithm>
+
+void drawTiled(Rasterizer & raster, const DisplayList & graphics, ThreadPool & pool, int tileSize)
+{
+    int columns = (raster.width() + tileSize - 1) / tileSize;
+    int rows = (raster.height() + tileSize - 1) / tileSize;
+    if (columns <= 0 || rows <= 0)
+    {
+        return;
+    }
+
+    //bin the atoms, walking the list in order keeps every bin in order
+    std::vector<std::vector<uint32_t>> bins(size_t(columns) * rows);
+    for (size_t i = 0; i < graphics.size(); i++)
+    {
+        PixelRect bounds = raster.pixelBounds(graphics[i]);
+        if (bounds.x0 >= bounds.x1 || bounds.y0 >= bounds.y1)
+        {
+            continue;
+        }
+        for (int row = bounds.y0 / tileSize; row <= (bounds.y1 - 1) / tileSize; row++)
+        {
+            for (int column = bounds.x0 / tileSize; column <= (bounds.x1 - 1) / tileSize; column++)
+            {
+                bins[size_t(row) * columns + column].push_back(i);
+            }
+        }
+    }
+
+    std::vector<std::vector<float>> scratch(pool.size());
+    pool.run(bins.size(), [&](size_t tile, unsigned worker)
+    {
+        int column = tile % columns;
+        int row = tile / columns;
+        PixelRect clip = {column * tileSize, row * tileSize,
+                          std::min((column + 1) * tileSize, raster.width()),
+                          std::min((row + 1) * tileSize, raster.height())};
+        const std::vector<uint32_t> & bin = bins[tile];
+        for (size_t i = 0; i < bin.size(); i++)
+        {
+            raster.draw(graphics[bin[i]], clip, scratch[worker]);
+        }
+    });
+}
@@ -0,0 +1,21 @@
+#ifndef TILE_RASTERIZER_HPP
+#define TILE_RASTERIZER_HPP
+
+// module includes
+#include "display_list.hpp"
+#include "rasterizer.hpp"
+#include "thread_pool.hpp"
+
+// the default edge length of a square tile in pixels
+const int DEFAULT_TILE_SIZE = 128;
+
+// Draw a display list into raster in parallel. Every atom is binned into
+// the square tiles its pixel bounds overlap, then the tiles are drawn
+// independently on the pool, each drawing its atoms in display list order
+// clipped to itself. Tiles never share a pixel so they write straight into
+// the image without locks, and the result is byte for byte what
+// raster.draw(graphics) gives.
+void drawTiled(Rasterizer & raster, const DisplayList & graphics, ThreadPool & pool,
+               int tileSize = DEFAULT_TILE_SIZE);
+
+#endif
@@ -0,0 +1,154 @@
+#include "tiled_graphics_view.hpp"
+
+#include <cmath>
+
+#include <QGraphicsScene>
+#include <QPaintEvent>
+#include <QWheelEvent>
+#include <QPainter>
+#include <QtMath>
+
+// edge length of a tile in device pixels
+static const int TILE_SIZE = 256;
+
+// zoom levels per doubling of the scale
+static const int LEVELS_PER_OCTAVE = 4;
+
+// default memory for cached tiles, in kilobytes
+static const int DEFAULT_CACHE_LIMIT = 64 * 1024;
+
+TiledGraphicsView::TiledGraphicsView(QGraphicsScene * scene, QWidget * parent): QGraphicsView(scene, parent)
+{
+    zoomLevel = 0;
+    tiles.setMaxCost(DEFAULT_CACHE_LIMIT);
+    setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    connect(scene, &QGraphicsScene::changed, this, &TiledGraphicsView::invalidateTiles);
+}
+
+void TiledGraphicsView::setCacheLimit(int kilobytes)
+{
+    tiles.setMaxCost(kilobytes);
+}
+
+int TiledGraphicsView::cachedTiles() const
+{
+    return tiles.size();
+}
+
+void TiledGraphicsView::zoom(int steps)
+{
+    zoomLevel += steps;
+    qreal scale = levelScale(zoomLevel);
+    setTransform(QTransform::fromScale(scale, scale));
+}
+
+//the scale factor of a zoom level
+qreal TiledGraphicsView::levelScale(int level) const
+{
+    return std::pow(2.0, qreal(level) / LEVELS_PER_OCTAVE);
+}
+
+//the area of the scene a tile covers
+QRectF TiledGraphicsView::tileRect(const TileKey & key) const
+{
+    qreal size = TILE_SIZE / levelScale(key.level);
+    return QRectF(key.x * size, key.y * size, size, size);
+}
+
+//rasterizes one tile of the scene and puts it in the cache
+QPixmap * TiledGraphicsView::renderTile(const TileKey & key)
+{
+    QPixmap * tile = new QPixmap(TILE_SIZE, TILE_SIZE);
+    tile->fill(viewport()->palette().color(QPalette::Base));
+    QPainter painter(tile);
+    painter.setRenderHints(renderHints());
+    scene()->render(&painter, QRectF(0, 0, TILE_SIZE, TILE_SIZE), tileRect(key), Qt::IgnoreAspectRatio);
+    painter.end();
+
+    //the cost is the memory of the tile in kilobytes
+    int cost = TILE_SIZE * TILE_SIZE * tile->depth() / 8 / 1024;
+    if (!tiles.insert(key, tile, cost))
+    {
+        return nullptr;
+    }
+    return tile;
+}
+
+void TiledGraphicsView::paintEvent(QPaintEvent * event)
+{
+    //the tiles only fit a plain zoom level, anything else is drawn directly
+    qreal scale = levelScale(zoomLevel);
+    if (transform() != QTransform::fromScale(scale, scale))
+    {
+        QGraphicsView::paintEvent(event);
+        return;
+    }
+
+    //where the scene origin lands in the viewport
+    QPointF origin = viewportTransform().map(QPointF(0, 0));
+    int originX = qRound(origin.x());
+    int originY = qRound(origin.y());
+
+    //blit every tile under the exposed area, rendering the missing ones
+    QRect exposed = event->rect().translated(-originX, -originY);
+    int firstX = qFloor(qreal(exposed.left()) / TILE_SIZE);
+    int lastX = qFloor(qreal(exposed.right()) / TILE_SIZE);
+    int firstY = qFloor(qreal(exposed.top()) / TILE_SIZE);
+    int lastY = qFloor(qreal(exposed.bottom()) / TILE_SIZE);
+    QPainter painter(viewport());
+    painter.setClipRect(event->rect());
+    for (int y = firstY; y <= lastY; y++)
+    {
+        for (int x = firstX; x <= lastX; x++)
+        {
+            TileKey key = {zoomLevel, x, y};
+            QPixmap * tile = tiles.object(key);
+            if (!tile)
+            {
+                tile = renderTile(key);
+            }
+            if (tile)
+            {
+                painter.drawPixmap(x * TILE_SIZE + originX, y * TILE_SIZE + originY, *tile);
+            }
+            else //the cache is too small to hold even this tile
+            {
+                scene()->render(&painter, QRectF(x * TILE_SIZE + originX, y * TILE_SIZE + originY, TILE_SIZE, TILE_SIZE),
+                    tileRect(key), Qt::IgnoreAspectRatio);
+            }
+        }
+    }
+}
+
+void TiledGraphicsView::wheelEvent(QWheelEvent * event)
+{
+    if (event->modifiers() & Qt::ControlModifier)
+    {
+        zoom(event->angleDelta().y() > 0 ? 1 : -1);
+        event->accept();
+    }
+    else
+    {
+        QGraphicsView::wheelEvent(event);
+    }
+}
+
+//drops the cached tiles, at every zoom level, that overlap changed parts of the scene
+void TiledGraphicsView::invalidateTiles(const QList<QRectF> & regions)
+{
+    QList<TileKey> keys = tiles.keys();
+    for (int i = 0; i < keys.size(); i++)
+    {
+        //grow the tile by a pixel so antialiased edges are not missed
+        qreal pixel = 1 / levelScale(keys[i].level);
+        QRectF rect = tileRect(keys[i]).adjusted(-pixel, -pixel, pixel, pixel);
+        for (int j = 0; j < regions.size(); j++)
+        {
+            if (rect.intersects(regions[j]))
+            {
+                tiles.remove(keys[i]);
+                break;
+            }
+        }
+    }
+}
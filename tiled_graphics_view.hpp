@@ -0,0 +1,67 @@
+#ifndef TILED_GRAPHICS_VIEW_HPP
+#define TILED_GRAPHICS_VIEW_HPP
+
+#include <QGraphicsView>
+#include <QPixmap>
+#include <QCache>
+#include <QList>
+#include <QRectF>
+
+// A TileKey names one fixed-size tile of the scene at one zoom level
+struct TileKey
+{
+  int level;
+  int x;
+  int y;
+  bool operator==(const TileKey & key) const
+  {
+    return level == key.level && x == key.x && y == key.y;
+  }
+};
+
+inline uint qHash(const TileKey & key, uint seed = 0)
+{
+  return qHash(key.level, seed) ^ qHash(key.x, seed + 1) ^ qHash(key.y, seed + 2);
+}
+
+// A QGraphicsView that paints the scene from a cache of rasterized tiles.
+// Tiles are rendered on demand, kept in a memory bounded LRU and dropped
+// only where the scene changes. Ctrl+wheel zooms in quarter octave steps.
+class TiledGraphicsView: public QGraphicsView
+{
+  Q_OBJECT
+
+public:
+
+  TiledGraphicsView(QGraphicsScene * scene, QWidget * parent = nullptr);
+
+  // the most memory the tiles may use, in kilobytes
+  void setCacheLimit(int kilobytes);
+
+  // the number of tiles currently cached
+  int cachedTiles() const;
+
+  // zoom in (positive) or out (negative) by a number of quarter octaves
+  void zoom(int steps);
+
+protected:
+
+  void paintEvent(QPaintEvent * event);
+
+  void wheelEvent(QWheelEvent * event);
+
+private slots:
+
+  void invalidateTiles(const QList<QRectF> & regions);
+
+private:
+
+  QCache<TileKey, QPixmap> tiles;
+  int zoomLevel;
+
+  qreal levelScale(int level) const;
+  QRectF tileRect(const TileKey & key) const;
+  QPixmap * renderTile(const TileKey & key);
+};
+
+#endif